@@ -0,0 +1,672 @@
+#include "ai.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+#include "combat.h"
+#include "dijkstra.h"
+#include "flow.h"
+#include "reach.h"
+#include "random.h"
+
+using Unit = WorldSnapshot::Unit;
+
+const Unit* WorldSnapshot::find(EntityId id) const {
+  auto it = std::lower_bound(
+      units.begin(), units.end(), id,
+      [](const Unit& unit, EntityId id) { return unit.id < id; });
+  return it != units.end() && it->id == id ? &*it : nullptr;
+}
+
+WorldSnapshot take_snapshot(const Game& game, const DijkstraGrid& moves,
+                            const FlowField& enemy_flow) {
+  WorldSnapshot world;
+  // The ECS keeps its components sorted by id, so these come out sorted too.
+  for (const auto& [id, gpos, actor, agent] :
+       game.ecs().read_all<GridPos, Actor, Agent>())
+    world.units.push_back(
+        {id, gpos.pos, agent.team, actor.stats, actor.hp, agent.energy,
+         actor.lifesteal});
+  world.turn = game.turn();
+  world.grid = &game.grid();
+  world.regions = &game.regions();
+  world.hierarchy = &game.hierarchy();
+  world.threats = &game.threats();
+  world.buckets = &game.unit_buckets();
+  world.moves = &moves;
+  world.enemy_flow = &enemy_flow;
+  return world;
+}
+
+// Writes over `enemies`. The UnitBuckets are as of the start of the turn, so
+// anyone who's gone since is skipped.
+static void enemies_in_range(const WorldSnapshot& world, const Unit& unit,
+                             const VisibilitySet& visible,
+                             std::vector<EntityId>& enemies) {
+  world.buckets->enemies_within(unit.team, unit.pos, unit.stats.range,
+                                enemies);
+  std::erase_if(enemies, [&](EntityId id) {
+    const Unit* other = world.find(id);
+    return !other || diamond_dist(unit.pos, other->pos) > unit.stats.range ||
+           !visible.contains(other->pos);
+  });
+}
+
+// When every enemy is walled off by other units, plan a rough path to the
+// closest one over the PathHierarchy and take as many steps along it as the
+// dijkstra map allows this turn. Only the first leg or two ever get refined
+// into tiles.
+static std::pair<glm::ivec2, bool> approach_distant_enemy(
+    const WorldSnapshot& world, const Unit& unit) {
+  const glm::ivec2 pos = unit.pos;
+  const unsigned int move = unit.stats.move;
+
+  glm::ivec2 enemy_pos;
+  bool found = false;
+  for (const Unit& other : world.units) {
+    if (other.id == unit.id || other.team == unit.team ||
+        !world.regions->connected(pos, other.pos))
+      continue;
+    if (!found || manh_dist(pos, other.pos) < manh_dist(pos, enemy_pos)) {
+      enemy_pos = other.pos;
+      found = true;
+    }
+  }
+  if (!found) return {pos, false};
+
+  HierarchicalPath path;
+  if (!world.hierarchy->plan(*world.grid, pos, enemy_pos, path))
+    return {pos, false};
+  world.hierarchy->refine(*world.grid, path, move + 1);
+
+  // The path ignores units, so stop at the last tile we can actually get to.
+  const DijkstraGrid& dijkstra = *world.moves;
+  glm::ivec2 best = pos;
+  for (std::size_t i = 1; i < path.tiles.size() && i <= move; ++i) {
+    glm::ivec2 tile = path.tiles[i];
+    if (!dijkstra.contains(tile)) break;
+    const DijkstraNode& node = dijkstra.at(tile);
+    if (node.entity) break;
+    if (node.dist <= move) best = tile;
+  }
+  return {best, best != pos};
+}
+
+// The tile within reach this turn that the fewest enemies could hit next turn,
+// going by the threat map. Ties go to the tile that's cheaper to get to.
+static glm::ivec2 safest_tile(const WorldSnapshot& world, const Unit& unit) {
+  glm::ivec2 best = unit.pos;
+  int best_threat = world.threats->threat_to(unit.team, unit.pos);
+  unsigned int best_dist = 0;
+  for (const auto& [tile, node] : *world.moves) {
+    if (node.dist > unit.stats.move || (node.entity && node.entity != unit.id))
+      continue;
+    int threat = world.threats->threat_to(unit.team, tile);
+    if (threat < best_threat ||
+        (threat == best_threat && node.dist < best_dist)) {
+      best = tile;
+      best_threat = threat;
+      best_dist = node.dist;
+    }
+  }
+  return best;
+}
+
+// When no enemy is in range yet but one could be after moving, the tile to
+// attack from that's quickest to get to. Enemies that can't be hit this turn
+// are ruled out by one lookup each in attack_reach().
+static std::pair<glm::ivec2, bool> attack_position(const WorldSnapshot& world,
+                                                   const Unit& unit) {
+  const DijkstraGrid& dijkstra = *world.moves;
+  const Stats& stats = unit.stats;
+  const BitGrid targets = attack_reach(dijkstra, stats.move, stats.range);
+  const int range = stats.range;
+
+  glm::ivec2 best;
+  unsigned int best_dist = DijkstraGrid::UNBOUNDED;
+  for (const Unit& other : world.units) {
+    if (other.team == unit.team || !targets.get(other.pos)) continue;
+    for (int y = -range; y <= range; ++y) {
+      for (int x = -range; x <= range; ++x) {
+        const glm::ivec2 p = other.pos + glm::ivec2(x, y);
+        if (!dijkstra.contains(p)) continue;
+        const DijkstraNode& node = dijkstra.at(p);
+        if (!node.dist || node.dist > stats.move || node.entity) continue;
+        if (node.dist < best_dist) {
+          best = p;
+          best_dist = node.dist;
+        }
+      }
+    }
+  }
+  return {best, best_dist != DijkstraGrid::UNBOUNDED};
+}
+
+Decision cpu_decide(const WorldSnapshot& world, EntityId id,
+                    VisionCache& vision) {
+  Decision decision;
+  const Unit* unit = world.find(id);
+  if (!unit) {
+    decision.type = Decision::PASS;
+    return decision;
+  }
+
+  if (!world.turn.did_action) {
+    // Kept between calls so that asking doesn't allocate.
+    static thread_local std::vector<EntityId> enemies;
+    enemies_in_range(world, *unit,
+                     vision.get(*world.grid, id, unit->pos, unit->stats.sight),
+                     enemies);
+    if (enemies.size()) {
+      decision.type = Decision::ATTACK_ENTITY;
+      decision.target = enemies.front();
+    }
+  }
+
+  // Badly hurt actors back off to wherever is least dangerous, if that's
+  // anywhere better than where they are.
+  const bool hurt = unit->hp * 3 <= unit->stats.max_hp;
+  if (decision.type == Decision::DECIDING && !world.turn.did_move && hurt) {
+    glm::ivec2 to = safest_tile(world, *unit);
+    if (to != unit->pos) {
+      decision.type = Decision::MOVE_TO;
+      decision.move_to = to;
+    }
+  }
+
+  if (decision.type == Decision::DECIDING && !world.turn.did_action &&
+      !world.turn.did_move && !hurt) {
+    const glm::ivec2 pos = unit->pos;
+    if (auto [to, ok] = attack_position(world, *unit); ok) {
+      decision.type = Decision::MOVE_TO;
+      decision.move_to = to;
+    } else if (world.enemy_flow->reaches(pos)) {
+      glm::ivec2 to = world.enemy_flow->follow(pos, unit->stats.move);
+      if (to != pos) {
+        decision.type = Decision::MOVE_TO;
+        decision.move_to = to;
+      }
+    } else if (auto [to, ok] = approach_distant_enemy(world, *unit); ok) {
+      decision.type = Decision::MOVE_TO;
+      decision.move_to = to;
+    }
+  }
+
+  if (decision.type == Decision::DECIDING) decision.type = Decision::PASS;
+  return decision;
+}
+
+// How far `from` has to walk to get within `range` of `to`, going around
+// nothing.
+static unsigned int steps_into_range(glm::ivec2 from, glm::ivec2 to,
+                                     unsigned int range) {
+  glm::ivec2 d = glm::abs(to - from);
+  return std::max(d.x - int(range), 0) + std::max(d.y - int(range), 0);
+}
+
+// Walks up to `steps` tiles from `from` to `to`, across and then up or down.
+static glm::ivec2 walk_toward(glm::ivec2 from, glm::ivec2 to,
+                              unsigned int steps) {
+  glm::ivec2 d = to - from;
+  int x = std::clamp(d.x, -int(steps), int(steps));
+  steps -= std::abs(x);
+  int y = std::clamp(d.y, -int(steps), int(steps));
+  return from + glm::ivec2(x, y);
+}
+
+// The rest of this plays turns out on copies of the snapshot's units, roughly:
+// units move in straight lines through walls and each other, and nobody's
+// status effects wear off. Damage and lifesteal work as in combat.h.
+using Units = std::vector<Unit>;
+
+static Unit& find_unit(Units& units, EntityId id) {
+  return *std::find_if(units.begin(), units.end(),
+                       [&](const Unit& u) { return u.id == id; });
+}
+
+// Whoever the game would pick next among those still standing, with their
+// energy spent, or null if nobody left can ever go.
+static Unit* next_to_act(Units& units) {
+  // Kept between calls so that rollouts don't allocate.
+  static thread_local std::vector<TurnTaker> takers;
+  static thread_local std::vector<Unit*> living;
+  takers.clear();
+  living.clear();
+  for (Unit& u : units) {
+    if (!u.hp) continue;
+    takers.push_back({&u.energy, &u.stats});
+    living.push_back(&u);
+  }
+  const int next = next_turn(takers, false);
+  return next < 0 ? nullptr : living[next];
+}
+
+static void carry_out(Units& units, Unit& actor, const TurnPlan& plan) {
+  actor.pos = plan.stand;
+  if (plan.target) {
+    Unit& target = find_unit(units, plan.target);
+    unsigned int damage = attack_damage(actor.stats, target.stats, target.hp);
+    target.hp -= damage;
+    if (actor.lifesteal)
+      actor.hp = std::min(actor.hp + damage, actor.stats.max_hp);
+  }
+}
+
+// Writes over `out` with a hit on each enemy `actor` could get to this turn
+// or, if there are none, a walk toward the nearest one.
+static void turn_options(const Units& units, const Unit& actor,
+                         std::vector<TurnPlan>& out) {
+  out.clear();
+  const Unit* nearest = nullptr;
+  for (const Unit& u : units) {
+    if (!u.hp || u.team == actor.team) continue;
+    if (!nearest || manh_dist(actor.pos, u.pos) <
+                    manh_dist(actor.pos, nearest->pos))
+      nearest = &u;
+    if (steps_into_range(actor.pos, u.pos, actor.stats.range) >
+        actor.stats.move)
+      continue;
+    glm::ivec2 d = u.pos - actor.pos;
+    const int range = actor.stats.range;
+    out.push_back({u.pos - glm::clamp(d, glm::ivec2(-range, -range),
+                                      glm::ivec2(range, range)),
+                   u.id});
+  }
+  if (out.empty() && nearest)
+    out.push_back({walk_toward(actor.pos, nearest->pos, actor.stats.move),
+                   EntityId()});
+}
+
+// Whichever of `options` hurts most, killing if it can.
+static const TurnPlan& most_harmful(const Units& units, const Unit& actor,
+                                    const std::vector<TurnPlan>& options) {
+  auto value = [&](const TurnPlan& plan) {
+    if (!plan.target) return std::pair(false, 0u);
+    const Unit& target = *std::find_if(
+        units.begin(), units.end(),
+        [&](const Unit& u) { return u.id == plan.target; });
+    unsigned int damage = attack_damage(actor.stats, target.stats, target.hp);
+    return std::pair(damage == target.hp, damage);
+  };
+  const TurnPlan* best = &options.front();
+  for (const TurnPlan& plan : options)
+    if (value(plan) > value(*best)) best = &plan;
+  return *best;
+}
+
+// Every unit's worth its hp and then some for being alive.
+static int worth(const Unit& u) { return u.hp ? 10 * int(u.hp) + 100 : 0; }
+
+// How far from the nearest enemy the plan leaves the actor, up to `cap`.
+static unsigned int distance_left(const WorldSnapshot& world,
+                                  const TurnPlan& plan, unsigned int cap) {
+  const DijkstraGrid& approach = world.enemy_flow->integration();
+  return approach.contains(plan.stand)
+         ? std::min(approach.at(plan.stand).dist, cap) : cap;
+}
+
+// Everything `unit` could do this turn, as far as the snapshot says. Whoever
+// it could hit from where it stands has to be in sight, as in cpu_decide();
+// from anywhere else, it'll find out once it gets there.
+static void root_options(const WorldSnapshot& world, const Unit& unit,
+                         VisionCache& vision, std::vector<TurnPlan>& out) {
+  out.clear();
+  const VisibilitySet& visible =
+    vision.get(*world.grid, unit.id, unit.pos, unit.stats.sight);
+  auto add_plans = [&](glm::ivec2 stand) {
+    out.push_back({stand, EntityId()});
+    if (world.turn.did_action) return;
+    for (const Unit& other : world.units) {
+      if (other.team == unit.team ||
+          diamond_dist(stand, other.pos) > unit.stats.range ||
+          (stand == unit.pos && !visible.contains(other.pos)))
+        continue;
+      out.push_back({stand, other.id});
+    }
+  };
+
+  if (world.turn.did_move) {
+    add_plans(unit.pos);
+    return;
+  }
+  for (const auto& [tile, node] : *world.moves)
+    if (node.dist <= unit.stats.move && (!node.dist || !node.entity))
+      add_plans(tile);
+}
+
+// The first step of a plan: walking to where it stands, then hitting.
+static Decision first_step(const TurnPlan& plan, glm::ivec2 pos) {
+  Decision decision;
+  if (plan.stand != pos) {
+    decision.type = Decision::MOVE_TO;
+    decision.move_to = plan.stand;
+  } else if (plan.target) {
+    decision.type = Decision::ATTACK_ENTITY;
+    decision.target = plan.target;
+  } else {
+    decision.type = Decision::PASS;
+  }
+  return decision;
+}
+
+void AnytimePlanner::begin(const WorldSnapshot& world, EntityId id,
+                           VisionCache& vision) {
+  world_ = &world;
+  id_ = id;
+  plans_.clear();
+  next_plan_ = 0;
+  depth_ = 1;
+  finished_depth_ = 0;
+  n_evaluated_ = 0;
+  time_spent_ = Clock::duration::zero();
+  best_ = cpu_decide(world, id, vision);
+
+  const Unit* unit = world.find(id);
+  if (!unit) return;
+  root_options(world, *unit, vision, options_);
+  for (const TurnPlan& plan : options_) plans_.push_back({plan});
+}
+
+int AnytimePlanner::evaluate(const Plan& plan, unsigned int depth) {
+  sim_.assign(world_->units.begin(), world_->units.end());
+
+  // The actor's own turn.
+  Unit& actor = find_unit(sim_, id_);
+  carry_out(sim_, actor, plan);
+  const Team team = actor.team;
+  ++n_evaluated_;
+
+  // Everyone after, each doing whatever hurts their enemies most.
+  for (unsigned int turn = 1; turn < depth; ++turn) {
+    Unit* next = next_to_act(sim_);
+    if (!next) break;
+    ++n_evaluated_;
+    turn_options(sim_, *next, options_);
+    if (!options_.empty())
+      carry_out(sim_, *next, most_harmful(sim_, *next, options_));
+  }
+
+  // Ties go to plans that close in on the enemy.
+  int score = 0;
+  for (const Unit& u : sim_) score += u.team == team ? worth(u) : -worth(u);
+  return score - distance_left(*world_, plan, 10);
+}
+
+bool AnytimePlanner::done() const {
+  return plans_.empty() || depth_ > MAX_DEPTH;
+}
+
+bool AnytimePlanner::search(Clock::time_point deadline) {
+  const Clock::time_point start = Clock::now();
+  while (!done()) {
+    for (; next_plan_ < plans_.size(); ++next_plan_) {
+      if (Clock::now() >= deadline) {
+        time_spent_ += Clock::now() - start;
+        return false;
+      }
+      plans_[next_plan_].score = evaluate(plans_[next_plan_], depth_);
+    }
+
+    // The next pass looks at the best plans first.
+    std::stable_sort(plans_.begin(), plans_.end(),
+                     [](const Plan& a, const Plan& b) {
+                       return a.score > b.score;
+                     });
+    best_ = first_step(plans_.front(), world_->find(id_)->pos);
+    finished_depth_ = depth_++;
+    next_plan_ = 0;
+  }
+  time_spent_ += Clock::now() - start;
+  return true;
+}
+
+double AnytimePlanner::evaluated_per_ms() const {
+  const double ms =
+    std::chrono::duration<double, std::milli>(time_spent_).count();
+  return ms > 0 ? n_evaluated_ / ms : 0;
+}
+
+namespace {
+
+// One thread's tree for MonteCarloPlanner. Nodes don't store the units; they
+// get played forward from the snapshot on the way down instead, which is
+// cheap next to the memory a copy per node would take.
+class SearchTree {
+  struct Node {
+    unsigned int first_child = 0;
+    unsigned int n_children = 0;
+    bool expanded = false;
+    unsigned int visits = 0;
+    // For whoever made the choice that led here.
+    Team team = Team::PLAYER;
+    double wins = 0;
+  };
+
+  // Past this many nodes, the tree stops growing and the rest of the search
+  // is playouts from its leaves.
+  static constexpr std::size_t MAX_NODES = 1 << 20;
+
+  const WorldSnapshot& world_;
+  EntityId id_;
+  const std::vector<TurnPlan>& root_options_;
+  std::vector<Node> nodes_;
+  std::mt19937_64 rng_;
+
+  // Scratch space.
+  Units sim_;
+  std::vector<TurnPlan> options_;
+  std::vector<unsigned int> path_;
+
+  // Unvisited children first, and then by UCB1.
+  unsigned int choose(const Node& node) const {
+    const double log_visits = std::log(double(node.visits));
+    unsigned int best = node.first_child;
+    double best_value = -1;
+    for (unsigned int i = node.first_child;
+         i < node.first_child + node.n_children; ++i) {
+      const Node& child = nodes_[i];
+      if (!child.visits) return i;
+      double value = child.wins / child.visits +
+                     std::sqrt(2 * log_visits / child.visits);
+      if (value > best_value) {
+        best = i;
+        best_value = value;
+      }
+    }
+    return best;
+  }
+
+public:
+  SearchTree(const WorldSnapshot& world, EntityId id,
+             const std::vector<TurnPlan>& root_options, std::uint64_t seed)
+    : world_(world), id_(id), root_options_(root_options), rng_(seed) {
+    nodes_.push_back({});
+  }
+
+  void rollout() {
+    sim_.assign(world_.units.begin(), world_.units.end());
+    const Team team = find_unit(sim_, id_).team;
+    path_.assign(1, 0);
+
+    // Down the tree until reaching a node that's never been tried.
+    unsigned int depth = 0;
+    unsigned int node = 0;
+    std::size_t first_step = 0;
+    bool in_tree = true;
+    for (; in_tree && depth < MonteCarloPlanner::MAX_DEPTH; ++depth) {
+      Unit* mover = depth ? next_to_act(sim_) : &find_unit(sim_, id_);
+      if (!mover) break;
+      if (depth) turn_options(sim_, *mover, options_);
+      const std::vector<TurnPlan>& options = depth ? options_ : root_options_;
+      if (options.empty()) break;
+
+      if (!nodes_[node].expanded) {
+        if (nodes_.size() + options.size() > MAX_NODES) {
+          carry_out(sim_, *mover, options[rng_() % options.size()]);
+          in_tree = false;
+          continue;
+        }
+        nodes_[node].expanded = true;
+        nodes_[node].first_child = nodes_.size();
+        nodes_[node].n_children = options.size();
+        nodes_.resize(nodes_.size() + options.size(),
+                      Node{.team = mover->team});
+      }
+      const unsigned int child = choose(nodes_[node]);
+      const std::size_t choice = child - nodes_[node].first_child;
+      if (!depth) first_step = choice;
+      carry_out(sim_, *mover, options[choice]);
+      in_tree = nodes_[child].visits > 0;
+      node = child;
+      path_.push_back(node);
+    }
+
+    // And the rest of the way mostly doing what hurts most, but not always,
+    // so that each playout tells something new.
+    for (; depth < MonteCarloPlanner::MAX_DEPTH; ++depth) {
+      Unit* mover = next_to_act(sim_);
+      if (!mover) break;
+      turn_options(sim_, *mover, options_);
+      if (options_.empty()) break;
+      carry_out(sim_, *mover,
+                rng_() % 4 ? most_harmful(sim_, *mover, options_)
+                           : options_[rng_() % options_.size()]);
+    }
+
+    // How much of what's left standing is the actor's side, with a little
+    // for closing in on the enemy.
+    int ours = 0;
+    int total = 0;
+    for (const Unit& u : sim_) {
+      total += worth(u);
+      if (u.team == team) ours += worth(u);
+    }
+    const double closeness =
+      1 - distance_left(world_, root_options_[first_step], 10) / 10.0;
+    const double result =
+      0.9 * (total ? double(ours) / total : 0.5) + 0.1 * closeness;
+
+    for (unsigned int i : path_) {
+      ++nodes_[i].visits;
+      nodes_[i].wins += nodes_[i].team == team ? result : 1 - result;
+    }
+  }
+
+  // How many times the actor's `i`th option was tried.
+  unsigned int root_visits(std::size_t i) const {
+    return nodes_[0].expanded ? nodes_[nodes_[0].first_child + i].visits : 0;
+  }
+  unsigned int n_rollouts() const { return nodes_[0].visits; }
+};
+
+}  // namespace
+
+MonteCarloPlanner::MonteCarloPlanner(unsigned int n_threads)
+  : n_threads_(n_threads ? n_threads
+                         : std::max(1u, std::thread::hardware_concurrency())) {
+}
+
+Decision MonteCarloPlanner::decide(const WorldSnapshot& world, EntityId id,
+                                   VisionCache& vision,
+                                   Clock::time_point deadline) {
+  const Clock::time_point start = Clock::now();
+  n_rollouts_ = 0;
+  time_spent_ = Clock::duration::zero();
+
+  Decision fallback = cpu_decide(world, id, vision);
+  const Unit* unit = world.find(id);
+  if (!unit) return fallback;
+  root_options(world, *unit, vision, options_);
+  if (options_.empty()) return fallback;
+
+  // Each thread grows its own tree, so they never wait on each other.
+  std::vector<SearchTree> trees;
+  for (unsigned int i = 0; i < n_threads_; ++i)
+    trees.emplace_back(world, id, options_, hash_u64(i));
+  auto worker = [&](SearchTree& tree) {
+    while (Clock::now() < deadline) tree.rollout();
+  };
+  std::vector<std::thread> threads;
+  for (unsigned int i = 1; i < n_threads_; ++i)
+    threads.emplace_back(worker, std::ref(trees[i]));
+  worker(trees[0]);
+  for (std::thread& t : threads) t.join();
+
+  // And then they vote.
+  std::size_t best = 0;
+  unsigned int best_visits = 0;
+  for (std::size_t i = 0; i < options_.size(); ++i) {
+    unsigned int visits = 0;
+    for (const SearchTree& tree : trees) visits += tree.root_visits(i);
+    if (visits > best_visits) {
+      best = i;
+      best_visits = visits;
+    }
+  }
+  for (const SearchTree& tree : trees) n_rollouts_ += tree.n_rollouts();
+  time_spent_ = Clock::now() - start;
+
+  return best_visits ? first_step(options_[best], unit->pos) : fallback;
+}
+
+double MonteCarloPlanner::rollouts_per_sec() const {
+  const double s = std::chrono::duration<double>(time_spent_).count();
+  return s > 0 ? n_rollouts_ / s : 0;
+}
+
+AiWorker::AiWorker(std::chrono::microseconds budget, Search search)
+  : budget_(budget), search_(search), thread_([this] { run(); }) { }
+
+AiWorker::~AiWorker() {
+  cancel();
+  state_.store(STOPPING, std::memory_order_release);
+  state_.notify_one();
+  thread_.join();
+}
+
+void AiWorker::run() {
+  while (true) {
+    int state = state_.load(std::memory_order_acquire);
+    if (state == STOPPING) return;
+    if (state != WORKING) {
+      state_.wait(state, std::memory_order_acquire);
+      continue;
+    }
+
+    if (budget_ > std::chrono::microseconds::zero() &&
+        search_ == MONTE_CARLO) {
+      decision_ = monte_carlo_.decide(
+          snapshot_, id_, vision_, MonteCarloPlanner::Clock::now() + budget_);
+    } else if (budget_ > std::chrono::microseconds::zero()) {
+      planner_.begin(snapshot_, id_, vision_);
+      planner_.search(AnytimePlanner::Clock::now() + budget_);
+      decision_ = planner_.best();
+    } else {
+      decision_ = cpu_decide(snapshot_, id_, vision_);
+    }
+    state_.store(DONE, std::memory_order_release);
+    state_.notify_all();
+  }
+}
+
+void AiWorker::start(WorldSnapshot snapshot, EntityId id) {
+  snapshot_ = std::move(snapshot);
+  id_ = id;
+  state_.store(WORKING, std::memory_order_release);
+  state_.notify_all();
+}
+
+bool AiWorker::poll(Decision& out) {
+  if (state_.load(std::memory_order_acquire) != DONE) return false;
+  out = decision_;
+  state_.store(IDLE, std::memory_order_release);
+  return true;
+}
+
+void AiWorker::cancel() {
+  int state;
+  while ((state = state_.load(std::memory_order_acquire)) == WORKING)
+    state_.wait(WORKING, std::memory_order_acquire);
+  if (state == DONE) state_.store(IDLE, std::memory_order_release);
+}
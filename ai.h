@@ -0,0 +1,216 @@
+#pragma once
+
+// The CPU's thinking, done on a copy of what it needs to know so that it can
+// happen on another thread while the game keeps drawing frames.
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <glm/vec2.hpp>
+
+#include "game.h"
+
+class DijkstraGrid;
+class FlowField;
+
+// What the CPU needs to know to make a decision. Units are copied, since they
+// move and die while the game runs. Everything else only changes between
+// turns, so it's pointed to; a snapshot is only good until the next turn
+// starts.
+struct WorldSnapshot {
+  struct Unit {
+    EntityId id;
+    glm::ivec2 pos;
+    Team team;
+    Stats stats;
+    unsigned int hp;
+    int energy;  // Agent::energy.
+    bool lifesteal = false;
+  };
+  std::vector<Unit> units;  // Sorted by id.
+  Turn turn;
+
+  const Grid* grid = nullptr;
+  const RegionMap* regions = nullptr;
+  const PathHierarchy* hierarchy = nullptr;
+  const ThreatMap* threats = nullptr;
+  const UnitBuckets* buckets = nullptr;
+
+  // Where the actor can move this turn, and the way to the nearest enemy of
+  // its team, from enemy_positions().
+  const DijkstraGrid* moves = nullptr;
+  const FlowField* enemy_flow = nullptr;
+
+  // Null if there's no such unit.
+  const Unit* find(EntityId id) const;
+};
+
+WorldSnapshot take_snapshot(const Game& game, const DijkstraGrid& moves,
+                            const FlowField& enemy_flow);
+
+// What `id` does next. `vision` is a cache of what each unit can see, which
+// should belong to whichever thread this is called on.
+Decision cpu_decide(const WorldSnapshot& world, EntityId id,
+                    VisionCache& vision);
+
+// What a unit does with a turn: where it ends up and who, if anyone, it hits
+// from there.
+struct TurnPlan {
+  glm::ivec2 stand;
+  EntityId target;  // Nobody, for just moving.
+};
+
+// Thinks for as long as there's time for. Every place the actor could move to
+// and everyone it could hit from there is scored by playing out the turns that
+// follow on a copy of the units, with everyone after it doing whatever hurts
+// their enemies most. Each pass looks one turn further ahead than the last, so
+// the search can be stopped whenever time's up and still have an answer: the
+// best plan from the deepest pass that finished, or cpu_decide()'s if none
+// has yet.
+//
+// The turns played out are rough. Units move in straight lines through walls
+// and each other, and nobody's status effects wear off.
+class AnytimePlanner {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  // How many turns, counting the actor's own, it will ever look ahead.
+  static constexpr unsigned int MAX_DEPTH = 8;
+
+private:
+  struct Plan : TurnPlan {
+    int score = 0;
+  };
+
+  const WorldSnapshot* world_ = nullptr;
+  EntityId id_;
+  std::vector<Plan> plans_;
+  std::size_t next_plan_ = 0;     // The next to score in this pass.
+  unsigned int depth_ = 1;        // How far this pass looks.
+  unsigned int finished_depth_ = 0;
+  Decision best_;
+
+  // Scratch space for playing turns out.
+  std::vector<WorldSnapshot::Unit> sim_;
+  std::vector<TurnPlan> options_;
+
+  std::size_t n_evaluated_ = 0;
+  Clock::duration time_spent_ = Clock::duration::zero();
+
+  int evaluate(const Plan& plan, unsigned int depth);
+
+public:
+  // Starts a new search for `id`, which is only good as long as `world` is.
+  void begin(const WorldSnapshot& world, EntityId id, VisionCache& vision);
+
+  // Keeps looking until `deadline` or until there's nothing left to look at,
+  // and then returns done(). Can be called again, e.g. once a frame, to carry
+  // on where it left off.
+  bool search(Clock::time_point deadline);
+  bool done() const;
+
+  const Decision& best() const { return best_; }
+
+  // How many turns ahead best() looked; zero if it's cpu_decide()'s.
+  unsigned int depth() const { return finished_depth_; }
+
+  // How many turns have been played out, and how quickly.
+  std::size_t n_evaluated() const { return n_evaluated_; }
+  double evaluated_per_ms() const;
+};
+
+// Monte Carlo tree search over the same rough turns as AnytimePlanner. Each
+// rollout walks down a tree of choices, the actor's and then everyone else's
+// in turn order, taking whichever has worked out best so far for whoever's
+// choosing while still trying the others now and then. Past the edge of the
+// tree, the turns are played out with everyone mostly doing what hurts most.
+//
+// Every thread grows a tree of its own from the same snapshot, so they never
+// wait on each other, and at the end they vote with how often each of the
+// actor's choices got tried.
+class MonteCarloPlanner {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  // How many turns, counting the actor's own, each rollout plays out.
+  static constexpr unsigned int MAX_DEPTH = 8;
+
+private:
+  unsigned int n_threads_;
+  std::vector<TurnPlan> options_;
+
+  std::size_t n_rollouts_ = 0;
+  Clock::duration time_spent_ = Clock::duration::zero();
+
+public:
+  // Zero threads means one per core.
+  explicit MonteCarloPlanner(unsigned int n_threads = 0);
+
+  // Searches until `deadline`, falling back on cpu_decide() if there was no
+  // time for even one rollout.
+  Decision decide(const WorldSnapshot& world, EntityId id, VisionCache& vision,
+                  Clock::time_point deadline);
+
+  // How the last decide() went, over every thread.
+  std::size_t n_rollouts() const { return n_rollouts_; }
+  double rollouts_per_sec() const;
+};
+
+// Runs cpu_decide() on a thread of its own. The main loop hands it a snapshot
+// with start() and checks back with poll() each frame, so nothing waits on the
+// CPU but the CPU's own turn. The two sides only ever trade ownership of the
+// snapshot and decision by flipping `state_`, so neither blocks the other.
+class AiWorker {
+  enum State { IDLE, WORKING, DONE, STOPPING };
+  std::atomic<int> state_ = IDLE;
+
+  // Only touched by the main thread while IDLE or DONE, and by the worker
+  // while WORKING.
+  WorldSnapshot snapshot_;
+  EntityId id_;
+  Decision decision_;
+  VisionCache vision_;
+
+public:
+  enum Search { ANYTIME, MONTE_CARLO };
+
+private:
+  // With a budget, decisions come from one of the planners instead.
+  std::chrono::microseconds budget_;
+  Search search_;
+  AnytimePlanner planner_;
+  MonteCarloPlanner monte_carlo_;
+
+  std::thread thread_;
+
+  void run();
+
+public:
+  // With a budget, each decision gets that long with the given planner.
+  explicit AiWorker(
+      std::chrono::microseconds budget = std::chrono::microseconds::zero(),
+      Search search = ANYTIME);
+  ~AiWorker();
+
+  AiWorker(const AiWorker&) = delete;
+  AiWorker& operator=(const AiWorker&) = delete;
+
+  // True when there's nothing being worked on or waiting to be picked up.
+  bool idle() const { return state_.load(std::memory_order_acquire) == IDLE; }
+
+  // Starts deciding for `id`. Only call when idle().
+  void start(WorldSnapshot snapshot, EntityId id);
+
+  // If a decision's ready, writes it to `out` and goes back to idle.
+  bool poll(Decision& out);
+
+  // Waits for any decision being made and throws it away, e.g. because the
+  // turn it was for is over.
+  void cancel();
+
+  // How the last search went. Only look while idle().
+  const AnytimePlanner& planner() const { return planner_; }
+  const MonteCarloPlanner& monte_carlo() const { return monte_carlo_; }
+};
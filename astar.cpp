@@ -0,0 +1,99 @@
+#include "astar.h"
+
+#include <algorithm>
+#include <functional>
+
+#include "math.h"
+
+void AStar::start(const Grid& grid, std::span<const Occupant> occupants) {
+  const glm::ivec2 min = grid.bounds_min();
+  const glm::ivec2 size = grid.bounds_max() - min;
+  if (min != min_ || size != size_) {
+    min_ = min;
+    size_ = size;
+    const std::size_t area = std::size_t(size.x) * size.y;
+    seen_.assign(area, 0);
+    cost_.resize(area);
+    prev_.resize(area);
+    closed_.assign(area, 0);
+    occupied_.assign(area, 0);
+    search_ = 0;
+  }
+
+  // Zero means "never", so start over if the count ever wraps around.
+  if (++search_ == 0) {
+    std::fill(seen_.begin(), seen_.end(), 0);
+    std::fill(closed_.begin(), closed_.end(), 0);
+    std::fill(occupied_.begin(), occupied_.end(), 0);
+    search_ = 1;
+  }
+
+  open_.clear();
+  n_expanded_ = 0;
+  for (const auto& [pos, id] : occupants)
+    if (in_box(pos)) occupied_[index(pos)] = search_;
+}
+
+bool AStar::find_path(const Grid& grid, std::span<const Occupant> occupants,
+                      glm::ivec2 start_pos, glm::ivec2 goal_pos,
+                      std::vector<glm::ivec2>& path) {
+  path.clear();
+  start(grid, occupants);
+  if (!in_box(start_pos) || !grid.at(start_pos).walkable ||
+      !in_box(goal_pos) || !grid.at(goal_pos).walkable)
+    return false;
+
+  const unsigned int start = index(start_pos);
+  const unsigned int goal = index(goal_pos);
+  seen_[start] = search_;
+  cost_[start] = 0;
+  prev_[start] = start;
+
+  // Among tiles that look equally good, the one furthest along goes first.
+  // Otherwise open ground turns into a wide front of ties.
+  auto push = [&](unsigned int i, glm::ivec2 pos) {
+    open_.emplace_back(cost_[i] + manh_dist(pos, goal_pos), ~cost_[i], i);
+    std::push_heap(open_.begin(), open_.end(), std::greater<>());
+  };
+  push(start, start_pos);
+
+  while (!open_.empty()) {
+    std::pop_heap(open_.begin(), open_.end(), std::greater<>());
+    const unsigned int i = std::get<2>(open_.back());
+    open_.pop_back();
+
+    // Tiles may be on the open list more than once if a cheaper way to them
+    // turned up later. Only the first one off counts.
+    if (closed_[i] == search_) continue;
+    closed_[i] = search_;
+    ++n_expanded_;
+    if (i == goal) break;
+
+    const glm::ivec2 pos = position(i);
+    for (glm::ivec2 next_pos : adjacent_positions(pos)) {
+      if (!in_box(next_pos)) continue;
+      const unsigned int next = index(next_pos);
+      if (closed_[next] == search_ ||
+          (occupied_[next] == search_ && next != goal))
+        continue;
+      auto [tile, exists] = grid.get(next_pos);
+      if (!exists || !tile.walkable) continue;
+
+      const unsigned int step = costs_ == PathCosts::STEPS
+        ? 1 : std::max<unsigned int>(tile.move_cost, 1);
+      const unsigned int cost = cost_[i] + step;
+      if (seen_[next] == search_ && cost_[next] <= cost) continue;
+      seen_[next] = search_;
+      cost_[next] = cost;
+      prev_[next] = i;
+      push(next, next_pos);
+    }
+  }
+
+  if (closed_[goal] != search_) return false;
+  for (unsigned int i = goal; i != start; i = prev_[i])
+    path.push_back(position(i));
+  path.push_back(start_pos);
+  std::reverse(path.begin(), path.end());
+  return true;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+// A* search for a single path between two tiles, for when flooding the map
+// with a DijkstraGrid would mostly find paths to places nobody's going.
+//
+// The scratch space is kept between searches and tagged with a search number
+// rather than cleared, so after the first few queries on a map, finding a path
+// doesn't allocate anything.
+
+#include <span>
+#include <tuple>
+#include <vector>
+
+#include <glm/vec2.hpp>
+
+#include "components.h"
+#include "grid.h"
+
+class AStar {
+  PathCosts costs_;
+
+  // Flat arrays over the grid's bounding box. A tile's cost_ and prev_ only
+  // mean something if its seen_ matches search_, and likewise it's only closed
+  // or occupied if those match.
+  glm::ivec2 min_ = {0, 0};
+  glm::ivec2 size_ = {0, 0};
+  std::vector<unsigned int> seen_;
+  std::vector<unsigned int> cost_;  // From the start.
+  std::vector<unsigned int> prev_;
+  std::vector<unsigned int> closed_;
+  std::vector<unsigned int> occupied_;
+  unsigned int search_ = 0;
+
+  // The open list as a binary heap of (estimate, tie break, index).
+  using OpenEntry = std::tuple<unsigned int, unsigned int, unsigned int>;
+  std::vector<OpenEntry> open_;
+
+  std::size_t n_expanded_ = 0;
+
+  void start(const Grid& grid, std::span<const Occupant> occupants);
+
+  unsigned int index(glm::ivec2 p) const {
+    return (p.y - min_.y) * size_.x + (p.x - min_.x);
+  }
+  glm::ivec2 position(unsigned int i) const {
+    return min_ + glm::ivec2(i % size_.x, i / size_.x);
+  }
+  bool in_box(glm::ivec2 p) const {
+    return p.x >= min_.x && p.y >= min_.y &&
+           p.x < min_.x + size_.x && p.y < min_.y + size_.y;
+  }
+
+public:
+  explicit AStar(PathCosts costs = PathCosts::STEPS) : costs_(costs) { }
+
+  // Fills `path` with every tile from start to goal, inclusive, just like
+  // ipath_to(). Units can't be walked through, but the start and goal are
+  // fair game so that the path can lead up to someone. Returns false, leaving
+  // `path` empty, if there's no way there.
+  bool find_path(const Grid& grid, std::span<const Occupant> occupants,
+                 glm::ivec2 start, glm::ivec2 goal,
+                 std::vector<glm::ivec2>& path);
+
+  std::vector<glm::ivec2> find_path(const Grid& grid,
+                                    std::span<const Occupant> occupants,
+                                    glm::ivec2 start, glm::ivec2 goal) {
+    std::vector<glm::ivec2> path;
+    find_path(grid, occupants, start, goal, path);
+    return path;
+  }
+
+  // How many tiles the last search took off the open list.
+  std::size_t n_expanded() const { return n_expanded_; }
+};
@@ -0,0 +1,122 @@
+// How far the CPU gets in the 200 ms the game gives it to decide: turns played
+// out per ms and how deep AnytimePlanner gets, and rollouts per second for
+// MonteCarloPlanner on one thread, two and one per core. The snapshot is a
+// rooms map with N_UNITS units split into two teams, from fixed seeds.
+//
+// Build with optimizations, e.g. `make benches CXXFLAGS=-O2`.
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+#include "../ai.h"
+#include "../flow.h"
+#include "../mapgen.h"
+#include "math.h"
+#include "random.h"
+
+constexpr int N_UNITS = 16;
+constexpr int N_DECISIONS = 4;
+constexpr auto BUDGET = std::chrono::milliseconds(200);
+
+int main() {
+  const Tile floor{.walkable = true, .glyph = MAP_FLOOR};
+  const Tile wall{.walkable = false, .opaque = true, .glyph = MAP_WALL};
+
+  MapGenParams params;
+  params.style = MapGenParams::ROOMS;
+  params.dimensions = {64, 64};
+  params.seed = 1234;
+  const Grid grid =
+    generate_grid(params, {{MAP_FLOOR, floor}, {MAP_WALL, wall}});
+
+  std::vector<glm::ivec2> floors;
+  for (const auto& [pos, tile] : grid)
+    if (tile.walkable) floors.push_back(pos);
+  std::sort(floors.begin(), floors.end(), [](glm::ivec2 a, glm::ivec2 b) {
+    return a.y != b.y ? a.y < b.y : a.x < b.x;
+  });
+
+  // Every other unit is the CPU's, all close enough to fight.
+  WorldSnapshot world;
+  const glm::ivec2 center = floors[floors.size() / 2];
+  for (unsigned int i = 0; world.units.size() < N_UNITS; ++i) {
+    glm::ivec2 pos = floors[hash_coords(params.seed, i, 0) % floors.size()];
+    if (manh_dist(pos, center) > 12) continue;
+    bool taken = false;
+    for (const WorldSnapshot::Unit& u : world.units)
+      taken = taken || u.pos == pos;
+    if (taken) continue;
+    const unsigned int n = world.units.size();
+    Stats stats;
+    world.units.push_back({EntityId{n + 1}, pos,
+                           n % 2 ? Team::PLAYER : Team::CPU, stats,
+                           stats.max_hp, int(hash_coords(2, n, 0) % 500)});
+  }
+
+  RegionMap regions;
+  regions.build(grid);
+  PathHierarchy hierarchy;
+  hierarchy.build(grid);
+  ThreatMap threats;
+  UnitBuckets buckets;
+  std::vector<ThreatMap::Unit> threat_units;
+  std::vector<UnitBuckets::Unit> bucket_units;
+  std::vector<Occupant> occupants;
+  std::vector<glm::ivec2> players;
+  for (const WorldSnapshot::Unit& u : world.units) {
+    threat_units.push_back({u.id, u.pos, u.team, int(u.stats.move),
+                            int(u.stats.range), int(u.stats.strength)});
+    bucket_units.push_back({u.id, u.pos, u.team});
+    occupants.emplace_back(u.pos, u.id);
+    if (u.team == Team::PLAYER) players.push_back(u.pos);
+  }
+  threats.update(grid.bounds_min(), grid.bounds_max(), threat_units);
+  buckets.update(grid.bounds_min(), grid.bounds_max(), bucket_units);
+  FlowField enemy_flow;
+  enemy_flow.generate(grid, players);
+
+  world.grid = &grid;
+  world.regions = &regions;
+  world.hierarchy = &hierarchy;
+  world.threats = &threats;
+  world.buckets = &buckets;
+  world.enemy_flow = &enemy_flow;
+
+  VisionCache vision;
+  DijkstraGrid moves(PathCosts::MOVE_COST);
+  std::cout << N_UNITS << " units, " << BUDGET.count() << " ms a decision"
+            << std::endl;
+
+  // Each decision is for one of the first few CPU units, as in the game.
+  auto for_each_actor = [&](auto decide) {
+    for (int i = 0; i < N_DECISIONS; ++i) {
+      const WorldSnapshot::Unit& actor = world.units[2 * i];
+      moves.generate(grid, occupants, actor.pos, actor.stats.move);
+      world.moves = &moves;
+      decide(actor.id);
+    }
+  };
+
+  AnytimePlanner planner;
+  for_each_actor([&](EntityId id) {
+    planner.begin(world, id, vision);
+    planner.search(AnytimePlanner::Clock::now() + BUDGET);
+    std::cout << "  anytime: looked " << planner.depth()
+              << " turns ahead, " << planner.evaluated_per_ms()
+              << " turns/ms" << std::endl;
+  });
+
+  for (unsigned int n_threads :
+       {1u, 2u, std::max(1u, std::thread::hardware_concurrency())}) {
+    MonteCarloPlanner monte_carlo(n_threads);
+    for_each_actor([&](EntityId id) {
+      monte_carlo.decide(world, id, vision,
+                         MonteCarloPlanner::Clock::now() + BUDGET);
+      std::cout << "  monte carlo, " << n_threads << " threads: "
+                << monte_carlo.n_rollouts() << " rollouts, "
+                << monte_carlo.rollouts_per_sec() << "/s" << std::endl;
+    });
+  }
+}
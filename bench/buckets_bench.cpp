@@ -0,0 +1,67 @@
+// Finding the enemies within range of a tile with 10,000 agents on a
+// 1024x1024 map: UnitBuckets against checking every agent, for a few ranges,
+// plus the time to sort everyone into buckets.
+//
+// Build with optimizations, e.g. `make benches CXXFLAGS=-O2`.
+
+#include <chrono>
+#include <iostream>
+
+#include "../buckets.h"
+#include "math.h"
+#include "random.h"
+
+using Clock = std::chrono::high_resolution_clock;
+
+constexpr int N_AGENTS = 10000;
+constexpr int N_QUERIES = 10000;
+constexpr int SIZE = 1024;
+
+static double us_since(Clock::time_point start) {
+  return std::chrono::duration<double, std::micro>(Clock::now() - start)
+    .count();
+}
+
+int main() {
+  std::vector<UnitBuckets::Unit> units;
+  for (unsigned int i = 0; i < N_AGENTS; ++i)
+    units.push_back({EntityId{i + 1},
+                     {int(hash_coords(1, i, 0) % SIZE),
+                      int(hash_coords(2, i, 0) % SIZE)},
+                     i % 2 ? Team::CPU : Team::PLAYER});
+
+  UnitBuckets buckets;
+  Clock::time_point start = Clock::now();
+  buckets.update({0, 0}, {SIZE, SIZE}, units);
+  std::cout << N_AGENTS << " agents sorted into buckets in "
+            << us_since(start) << " us" << std::endl;
+
+  std::vector<EntityId> near;
+  for (unsigned int range : {1, 4, 8, 16}) {
+    std::size_t n_found = 0;
+    start = Clock::now();
+    for (int q = 0; q < N_QUERIES; ++q) {
+      buckets.enemies_within(units[q % N_AGENTS].team,
+                             units[q % N_AGENTS].pos, range, near);
+      n_found += near.size();
+    }
+    double buckets_us = us_since(start);
+
+    std::size_t n_checked = 0;
+    start = Clock::now();
+    for (int q = 0; q < N_QUERIES; ++q) {
+      near.clear();
+      const UnitBuckets::Unit& from = units[q % N_AGENTS];
+      for (const UnitBuckets::Unit& u : units)
+        if (u.team != from.team && diamond_dist(u.pos, from.pos) <= range)
+          near.push_back(u.id);
+      n_checked += near.size();
+    }
+    double every_us = us_since(start);
+
+    std::cout << "range " << range << ": buckets " << buckets_us / N_QUERIES
+              << " us, every agent " << every_us / N_QUERIES
+              << " us per query (" << n_found << " and " << n_checked
+              << " found)" << std::endl;
+  }
+}
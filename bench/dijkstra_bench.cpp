@@ -0,0 +1,125 @@
+// Nanoseconds per tile reached for DijkstraGrid::generate() on open arenas and
+// caves, with a few units standing around to block the flood, and the time for
+// a flood bounded by a typical move range. Then one unit at a time takes a
+// step and the whole field is repaired, which is compared against filling it
+// again from scratch. The same fills are then repeated counting move costs, on
+// a copy of the map where each tile costs one to three at random.
+//
+// Build with optimizations, e.g. `make benches CXXFLAGS=-O2`.
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+#include "../dijkstra.h"
+#include "../mapgen.h"
+#include "random.h"
+
+using Clock = std::chrono::high_resolution_clock;
+
+constexpr int N_SOURCES = 20;
+constexpr int N_UNITS = 50;
+constexpr unsigned int MOVE_RANGE = 6;
+
+static void run(const char* label, const Grid& grid,
+                PathCosts costs) {
+  std::vector<glm::ivec2> floors;
+  for (const auto& [pos, tile] : grid)
+    if (tile.walkable) floors.push_back(pos);
+  std::sort(floors.begin(), floors.end(), [](glm::ivec2 a, glm::ivec2 b) {
+    return a.y != b.y ? a.y < b.y : a.x < b.x;
+  });
+
+  std::vector<Occupant> units;
+  for (int i = 0; i < N_UNITS; ++i)
+    units.emplace_back(floors[hash_coords(1, i, 0) % floors.size()],
+                       EntityId{unsigned(i + 1)});
+
+  DijkstraGrid dijkstra(costs);
+  std::size_t n_reached = 0;
+  Clock::time_point start = Clock::now();
+  for (int i = 0; i < N_SOURCES; ++i) {
+    dijkstra.generate(grid, units,
+                      floors[hash_coords(2, i, 0) % floors.size()]);
+    n_reached += dijkstra.size();
+  }
+  double ns = std::chrono::duration<double, std::nano>(
+      Clock::now() - start).count();
+  std::cout << label << ": " << ns / n_reached << " ns/tile ("
+            << n_reached / N_SOURCES << " tiles per fill)" << std::endl;
+
+  start = Clock::now();
+  for (int i = 0; i < N_SOURCES; ++i)
+    dijkstra.generate(grid, units,
+                      floors[hash_coords(2, i, 0) % floors.size()],
+                      MOVE_RANGE);
+  double us = std::chrono::duration<double, std::micro>(
+      Clock::now() - start).count();
+  std::cout << "  within " << MOVE_RANGE << ": " << us / N_SOURCES
+            << " us per fill" << std::endl;
+
+  // Walk each unit one step to a free tile, if there is one, and catch up.
+  const glm::ivec2 source = floors[hash_coords(2, 0, 0) % floors.size()];
+  dijkstra.generate(grid, units, source);
+  const std::size_t full_size = dijkstra.size();
+  std::vector<std::vector<Occupant>> after;
+  std::vector<std::vector<glm::ivec2>> changes;
+  for (int i = 0; i < N_UNITS; ++i) {
+    std::vector<Occupant>& moved = after.emplace_back(
+        after.empty() ? units : after.back());
+    glm::ivec2& pos = moved[i].first;
+    for (glm::ivec2 next : adjacent_positions(pos)) {
+      auto [tile, exists] = grid.get(next);
+      if (exists && tile.walkable && next != source &&
+          std::none_of(moved.begin(), moved.end(),
+                       [&](const Occupant& o) { return o.first == next; })) {
+        changes.push_back({pos, next});
+        pos = next;
+        break;
+      }
+    }
+    if (changes.size() < after.size()) changes.emplace_back();
+  }
+
+  std::size_t n_touched = 0;
+  start = Clock::now();
+  for (int i = 0; i < N_UNITS; ++i)
+    n_touched += dijkstra.repair(grid, after[i], changes[i]);
+  double repair_us = std::chrono::duration<double, std::micro>(
+      Clock::now() - start).count();
+
+  DijkstraGrid fresh(costs);
+  start = Clock::now();
+  for (int i = 0; i < N_UNITS; ++i) fresh.generate(grid, after[i], source);
+  double fresh_us = std::chrono::duration<double, std::micro>(
+      Clock::now() - start).count();
+  std::cout << "  repair after a step: " << repair_us / N_UNITS << " us, "
+            << n_touched / N_UNITS << " of " << full_size
+            << " tiles touched; generate: " << fresh_us / N_UNITS << " us"
+            << std::endl;
+}
+
+static void run(const std::string& label, Grid grid) {
+  run(label.c_str(), grid, PathCosts::STEPS);
+
+  for (auto& [pos, tile] : grid)
+    tile.move_cost = 1 + hash_coords(3, pos.x, pos.y) % 3;
+  run((label + ", move costs").c_str(), grid, PathCosts::MOVE_COST);
+}
+
+int main() {
+  const Tile floor{.walkable = true, .glyph = MAP_FLOOR};
+  const Tile wall{.walkable = false, .opaque = true, .glyph = MAP_WALL};
+
+  for (int size : {64, 256, 1024}) {
+    run("arena " + std::to_string(size),
+        arena_grid({size, size}, wall, floor));
+
+    MapGenParams params;
+    params.style = MapGenParams::CAVES;
+    params.dimensions = {size, size};
+    params.seed = 1234;
+    run("caves " + std::to_string(size),
+        generate_grid(params, {{MAP_FLOOR, floor}, {MAP_WALL, wall}}));
+  }
+}
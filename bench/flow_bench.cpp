@@ -0,0 +1,82 @@
+// Sending 500 units to the same place, on open arenas and caves: one flow field
+// shared by all of them against an A* path each. Counts the time to build the
+// field and to walk every unit all the way there a step at a time.
+//
+// Build with optimizations, e.g. `make benches CXXFLAGS=-O2`.
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+#include "../astar.h"
+#include "../flow.h"
+#include "../mapgen.h"
+#include "random.h"
+
+using Clock = std::chrono::high_resolution_clock;
+
+constexpr int N_UNITS = 500;
+
+static double us_since(Clock::time_point start) {
+  return std::chrono::duration<double, std::micro>(Clock::now() - start)
+    .count();
+}
+
+static void run(const std::string& label, const Grid& grid) {
+  std::vector<glm::ivec2> floors;
+  for (const auto& [pos, tile] : grid)
+    if (tile.walkable) floors.push_back(pos);
+  std::sort(floors.begin(), floors.end(), [](glm::ivec2 a, glm::ivec2 b) {
+    return a.y != b.y ? a.y < b.y : a.x < b.x;
+  });
+  std::vector<glm::ivec2> goal = {floors[floors.size() / 2]};
+  std::vector<glm::ivec2> units;
+  for (int i = 0; i < N_UNITS; ++i)
+    units.push_back(floors[hash_coords(1, i, 0) % floors.size()]);
+
+  Clock::time_point start = Clock::now();
+  FlowField flow;
+  flow.generate(grid, goal);
+  double build_us = us_since(start);
+
+  std::size_t flow_steps = 0;
+  start = Clock::now();
+  for (glm::ivec2 pos : units) {
+    for (auto [next, ok] = flow.next(pos); ok;
+         std::tie(next, ok) = flow.next(next))
+      ++flow_steps;
+  }
+  double walk_us = us_since(start);
+
+  std::size_t astar_steps = 0;
+  AStar astar(PathCosts::MOVE_COST);
+  std::vector<glm::ivec2> path;
+  start = Clock::now();
+  for (glm::ivec2 pos : units)
+    if (astar.find_path(grid, {}, pos, goal[0], path))
+      astar_steps += path.size() - 1;
+  double astar_us = us_since(start);
+
+  std::cout << label << "\n"
+            << "  flow field: " << build_us << " us to build, "
+            << walk_us << " us for " << flow_steps << " steps\n"
+            << "  A*: " << astar_us << " us for " << astar_steps
+            << " steps" << std::endl;
+}
+
+int main() {
+  const Tile floor{.walkable = true, .glyph = MAP_FLOOR};
+  const Tile wall{.walkable = false, .opaque = true, .glyph = MAP_WALL};
+
+  for (int size : {64, 256, 1024}) {
+    run("arena " + std::to_string(size),
+        arena_grid({size, size}, wall, floor));
+
+    MapGenParams params;
+    params.style = MapGenParams::CAVES;
+    params.dimensions = {size, size};
+    params.seed = 1234;
+    run("caves " + std::to_string(size),
+        generate_grid(params, {{MAP_FLOOR, floor}, {MAP_WALL, wall}}));
+  }
+}
@@ -0,0 +1,70 @@
+// Field of view for 1,000 actors with a sight radius of 12 on a cave map:
+// first from scratch, then through the VisionCache after nothing changed,
+// after a few tiles changed and after some of the actors moved.
+//
+// Build with optimizations, e.g. `make benches CXXFLAGS=-O2`.
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+#include "../fov.h"
+#include "../mapgen.h"
+#include "random.h"
+
+using Clock = std::chrono::high_resolution_clock;
+
+constexpr int N_ACTORS = 1000;
+constexpr int RADIUS = 12;
+
+int main() {
+  const Tile floor{.walkable = true, .glyph = MAP_FLOOR};
+  const Tile wall{.walkable = false, .opaque = true, .glyph = MAP_WALL};
+
+  MapGenParams params;
+  params.style = MapGenParams::CAVES;
+  params.dimensions = {256, 256};
+  params.seed = 1234;
+  Grid grid = generate_grid(params, {{MAP_FLOOR, floor}, {MAP_WALL, wall}});
+
+  std::vector<glm::ivec2> floors;
+  for (const auto& [pos, tile] : grid)
+    if (tile.walkable) floors.push_back(pos);
+  std::sort(floors.begin(), floors.end(), [](glm::ivec2 a, glm::ivec2 b) {
+    return a.y != b.y ? a.y < b.y : a.x < b.x;
+  });
+
+  std::vector<glm::ivec2> actors;
+  for (int i = 0; i < N_ACTORS; ++i)
+    actors.push_back(floors[hash_coords(params.seed, i, 0) % floors.size()]);
+
+  VisionCache cache;
+  auto run = [&](const char* label) {
+    unsigned int computed_before = cache.n_computed();
+    std::size_t n_visible = 0;
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < N_ACTORS; ++i) {
+      const VisibilitySet& visible =
+        cache.get(grid, EntityId{unsigned(i + 1)}, actors[i], RADIUS);
+      n_visible += visible.contains(actors[i]);
+    }
+    double ms = std::chrono::duration<double, std::milli>(
+        Clock::now() - start).count();
+    std::cout << label << ": " << ms << " ms, "
+              << cache.n_computed() - computed_before << " recomputed ("
+              << n_visible << " checked)" << std::endl;
+  };
+
+  run("from scratch");
+  run("nothing changed");
+
+  for (int i = 0; i < 20; ++i) {
+    glm::ivec2 pos = floors[hash_coords(params.seed, i, 1) % floors.size()];
+    grid.set(pos, grid.at(pos).opaque ? floor : wall);
+  }
+  run("20 tiles changed");
+
+  for (int i = 0; i < N_ACTORS; i += 10)
+    actors[i] = floors[hash_coords(params.seed, i, 2) % floors.size()];
+  run("10% of actors moved");
+}
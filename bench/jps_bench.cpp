@@ -0,0 +1,92 @@
+// Jump point search against plain A*, counting steps, on open arenas and
+// caves: tiles taken off the open list and time per path between random pairs
+// of floor tiles. Also checks that both find paths of the same length.
+//
+// Build with optimizations, e.g. `make benches CXXFLAGS=-O2`.
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+#include "../astar.h"
+#include "../jps.h"
+#include "../mapgen.h"
+#include "random.h"
+
+using Clock = std::chrono::high_resolution_clock;
+
+constexpr int N_PATHS = 100;
+
+static double us_since(Clock::time_point start) {
+  return std::chrono::duration<double, std::micro>(Clock::now() - start)
+    .count();
+}
+
+static void run(const std::string& label, const Grid& grid) {
+  std::vector<glm::ivec2> floors;
+  for (const auto& [pos, tile] : grid)
+    if (tile.walkable) floors.push_back(pos);
+  std::sort(floors.begin(), floors.end(), [](glm::ivec2 a, glm::ivec2 b) {
+    return a.y != b.y ? a.y < b.y : a.x < b.x;
+  });
+  std::vector<std::pair<glm::ivec2, glm::ivec2>> queries;
+  for (int i = 0; i < N_PATHS; ++i)
+    queries.emplace_back(floors[hash_coords(1, i, 0) % floors.size()],
+                         floors[hash_coords(1, i, 1) % floors.size()]);
+
+  Clock::time_point start = Clock::now();
+  BitGrid walkable = walkable_bits(grid);
+  double bits_us = us_since(start);
+
+  // Once first so that neither pays for allocating its scratch space.
+  AStar astar;
+  JumpPointSearch jps;
+  std::vector<glm::ivec2> path;
+  astar.find_path(grid, {}, queries[0].first, queries[0].second, path);
+  jps.find_path(walkable, queries[0].first, queries[0].second, path);
+
+  std::vector<std::size_t> lengths;
+  std::size_t astar_expanded = 0;
+  start = Clock::now();
+  for (auto [from, to] : queries) {
+    astar.find_path(grid, {}, from, to, path);
+    astar_expanded += astar.n_expanded();
+    lengths.push_back(path.size());
+  }
+  double astar_us = us_since(start);
+
+  int mismatches = 0;
+  std::size_t jps_expanded = 0;
+  start = Clock::now();
+  for (int i = 0; i < N_PATHS; ++i) {
+    jps.find_path(walkable, queries[i].first, queries[i].second, path);
+    jps_expanded += jps.n_expanded();
+    mismatches += path.size() != lengths[i];
+  }
+  double jps_us = us_since(start);
+
+  std::cout << label << " (BitGrid built in " << bits_us << " us)\n"
+            << "  A*:  " << astar_us / N_PATHS << " us, "
+            << astar_expanded / N_PATHS << " expanded per path\n"
+            << "  JPS: " << jps_us / N_PATHS << " us, "
+            << jps_expanded / N_PATHS << " expanded per path";
+  if (mismatches) std::cout << ", " << mismatches << " DIFFERENT LENGTHS";
+  std::cout << std::endl;
+}
+
+int main() {
+  const Tile floor{.walkable = true, .glyph = MAP_FLOOR};
+  const Tile wall{.walkable = false, .opaque = true, .glyph = MAP_WALL};
+
+  for (int size : {256, 1024}) {
+    run("arena " + std::to_string(size),
+        arena_grid({size, size}, wall, floor));
+
+    MapGenParams params;
+    params.style = MapGenParams::CAVES;
+    params.dimensions = {size, size};
+    params.seed = 1234;
+    run("caves " + std::to_string(size),
+        generate_grid(params, {{MAP_FLOOR, floor}, {MAP_WALL, wall}}));
+  }
+}
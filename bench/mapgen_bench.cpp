@@ -0,0 +1,68 @@
+// Measures how many tiles per second generate_map_chunks() fills for each map
+// style, single threaded and on every core, and checks that both produce the
+// same map.
+//
+// Build with optimizations, e.g. `make benches CXXFLAGS=-O2`.
+
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+#include "../mapgen.h"
+
+using Clock = std::chrono::high_resolution_clock;
+
+static double seconds_since(Clock::time_point start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+static bool same_cells(const std::vector<MapChunk>& a,
+                       const std::vector<MapChunk>& b) {
+  if (a.size() != b.size()) return false;
+  for (std::size_t i = 0; i < a.size(); ++i)
+    if (a[i].cells != b[i].cells) return false;
+  return true;
+}
+
+int main() {
+  const unsigned int n_cores =
+    std::max(1u, std::thread::hardware_concurrency());
+  const std::unordered_map<char, Tile> tile_types = {
+    {MAP_WALL, Tile{.walkable = false, .glyph = MAP_WALL}},
+    {MAP_FLOOR, Tile{.walkable = true, .glyph = MAP_FLOOR}},
+  };
+
+  for (auto style : {MapGenParams::ROOMS, MapGenParams::CAVES}) {
+    for (int size : {256, 1024, 2048}) {
+      MapGenParams params;
+      params.style = style;
+      params.dimensions = {size, size};
+      params.seed = 1234;
+
+      std::vector<MapChunk> chunks[2];
+      for (unsigned int i = 0; i < 2; ++i) {
+        params.n_threads = i ? n_cores : 1;
+        Clock::time_point start = Clock::now();
+        chunks[i] = generate_map_chunks(params);
+        double secs = seconds_since(start);
+
+        std::cout << (style == MapGenParams::ROOMS ? "rooms" : "caves")
+                  << ' ' << size << 'x' << size
+                  << " threads=" << params.n_threads << ": "
+                  << double(size) * size / secs / 1e6 << " Mtiles/s"
+                  << std::endl;
+      }
+
+      if (!same_cells(chunks[0], chunks[1]))
+        std::cerr << "  MISMATCH between 1 and " << n_cores << " threads!"
+                  << std::endl;
+
+      Clock::time_point start = Clock::now();
+      Grid grid = grid_from_chunks(chunks[1], tile_types);
+      double secs = seconds_since(start);
+      std::cout << "  grid_from_chunks: "
+                << double(size) * size / secs / 1e6 << " Mtiles/s"
+                << std::endl;
+    }
+  }
+}
@@ -0,0 +1,300 @@
+// Latency percentiles and throughput for each kind of path query the game
+// makes, on open arenas, rooms joined by corridors and caves from 64x64 up to
+// 2048x2048, with N_ACTORS units standing around in two teams and patches of
+// mud that cost more to walk through. The queries that can count move costs
+// run both ways; JPS, the wavefront and HPA* only count steps. Maps, units and
+// queries all come from fixed seeds, so runs can be compared from one commit
+// to the next.
+//
+// Build with optimizations, e.g. `make benches CXXFLAGS=-O2`. Pass a size to
+// stop at for a quicker run, e.g. `bench/paths_bench 256`.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+
+#include "../astar.h"
+#include "../bitboard.h"
+#include "../dijkstra.h"
+#include "../flow.h"
+#include "../hpa.h"
+#include "../jps.h"
+#include "../mapgen.h"
+#include "../wavefront.h"
+#include "random.h"
+
+using Clock = std::chrono::high_resolution_clock;
+
+constexpr int N_ACTORS = 100;
+constexpr unsigned int MOVE_RANGE = 6;
+
+// The time each query took, in nanoseconds.
+class Timings {
+  std::vector<double> ns_;
+  Clock::time_point start_;
+
+public:
+  void start() { start_ = Clock::now(); }
+  void stop() {
+    ns_.push_back(std::chrono::duration<double, std::nano>(
+        Clock::now() - start_).count());
+  }
+
+  void report(const std::string& label) {
+    if (ns_.empty()) return;
+    std::sort(ns_.begin(), ns_.end());
+    auto percentile = [&](double p) {
+      return ns_[std::min(ns_.size() - 1, std::size_t(p * ns_.size()))] /
+             1000;
+    };
+    double total = 0;
+    for (double ns : ns_) total += ns;
+    std::cout << "  " << std::left << std::setw(25) << label << std::right
+              << std::fixed << std::setprecision(2) << std::setw(4)
+              << ns_.size() << " queries, us p50 " << std::setw(10)
+              << percentile(0.5) << " p90 " << std::setw(10)
+              << percentile(0.9) << " p99 " << std::setw(10)
+              << percentile(0.99) << " max " << std::setw(10)
+              << ns_.back() / 1000 << std::setprecision(1) << std::setw(11)
+              << ns_.size() / (total / 1e9) << " /s" << std::endl;
+    ns_.clear();
+  }
+};
+
+// Turns patches of floor into mud, about a quarter of it, so that counting
+// move costs finds different paths than counting steps.
+static Grid add_mud(Grid grid) {
+  for (auto& [pos, tile] : grid) {
+    if (tile.walkable && hash_coords(5, pos.x / 4, pos.y / 4) % 4 == 0)
+      tile.move_cost = 2;
+  }
+  return grid;
+}
+
+static const char* costs_name(PathCosts costs) {
+  return costs == PathCosts::STEPS ? " (steps)" : " (move cost)";
+}
+
+static void run(const std::string& label, const Grid& grid) {
+  std::vector<glm::ivec2> floors;
+  for (const auto& [pos, tile] : grid)
+    if (tile.walkable) floors.push_back(pos);
+  std::sort(floors.begin(), floors.end(), [](glm::ivec2 a, glm::ivec2 b) {
+    return a.y != b.y ? a.y < b.y : a.x < b.x;
+  });
+  auto random_floor = [&](int kind, int i) {
+    return floors[hash_coords(kind, i, 0) % floors.size()];
+  };
+
+  // Every other actor is an enemy.
+  std::vector<Occupant> actors;
+  std::vector<glm::ivec2> teams[2];
+  for (int i = 0; i < N_ACTORS; ++i) {
+    actors.emplace_back(random_floor(1, i), EntityId{unsigned(i + 1)});
+    teams[i % 2].push_back(actors.back().first);
+  }
+
+  // Whole-map queries get slow on the big maps, so there are fewer of them.
+  const int n_long = grid.bounds_max().x - grid.bounds_min().x <= 256 ? 50
+                     : grid.bounds_max().x - grid.bounds_min().x <= 1024 ? 10
+                     : 4;
+
+  std::cout << label << ", " << floors.size() << " floor tiles" << std::endl;
+  Timings timings;
+
+  // Adds up every answer so that none of the queries can be optimized away.
+  std::size_t checksum = 0;
+  auto use = [&](glm::ivec2 p) { checksum += p.x * 31 + p.y; };
+  std::vector<glm::ivec2> path;
+
+  for (PathCosts costs : {PathCosts::STEPS, PathCosts::MOVE_COST}) {
+    const std::string name = costs_name(costs);
+    DijkstraGrid field(costs);
+
+    // Where each actor can move at the start of its turn.
+    for (const auto& [pos, id] : actors) {
+      timings.start();
+      field.generate(grid, actors, pos, MOVE_RANGE);
+      timings.stop();
+      checksum += field.size();
+    }
+    timings.report("move field" + name);
+
+    for (int i = 0; i < n_long; ++i) {
+      timings.start();
+      field.generate(grid, actors, actors[i % N_ACTORS].first);
+      timings.stop();
+    }
+    timings.report("full field" + name);
+
+    // Paths back to the source of the last full field, into one buffer.
+    std::vector<glm::ivec2> targets;
+    for (int i = 0; targets.size() < 500 && i < 5000; ++i)
+      if (field.contains(random_floor(2, i)))
+        targets.push_back(random_floor(2, i));
+    for (glm::ivec2 target : targets) {
+      timings.start();
+      ipath_to(field, target, path);
+      timings.stop();
+      use(path[path.size() / 2]);
+    }
+    timings.report("ipath_to" + name);
+
+    for (glm::ivec2 target : targets) {
+      timings.start();
+      glm::ivec2 to = rewind_until(
+          field, target, [](glm::ivec2, const DijkstraNode& node) {
+            return node.dist <= MOVE_RANGE;
+          });
+      timings.stop();
+      use(to);
+    }
+    timings.report("rewind_until" + name);
+
+    // How the CPU closes in on the nearest enemy: one field per team, then a
+    // walk down it per actor.
+    DijkstraGrid enemy_fields[2] = {DijkstraGrid(costs), DijkstraGrid(costs)};
+    for (int i = 0; i < n_long; ++i) {
+      timings.start();
+      enemy_fields[i % 2].generate(grid, actors, teams[(i + 1) % 2]);
+      timings.stop();
+    }
+    timings.report("enemy field" + name);
+
+    for (int i = 0; i < N_ACTORS; ++i) {
+      timings.start();
+      glm::ivec2 to =
+        descend(enemy_fields[i % 2], actors[i].first, MOVE_RANGE);
+      timings.stop();
+      use(to);
+    }
+    timings.report("descend" + name);
+
+    // The same, but with a flow field that the whole team shares, so units
+    // are left out of it.
+    FlowField flows[2] = {FlowField(costs), FlowField(costs)};
+    for (int i = 0; i < n_long; ++i) {
+      timings.start();
+      flows[i % 2].generate(grid, teams[(i + 1) % 2]);
+      timings.stop();
+    }
+    timings.report("flow field" + name);
+
+    for (int i = 0; i < N_ACTORS; ++i) {
+      timings.start();
+      glm::ivec2 to = flows[i % 2].follow(actors[i].first, MOVE_RANGE);
+      timings.stop();
+      use(to);
+    }
+    timings.report("follow" + name);
+
+    AStar astar(costs);
+    for (int i = 0; i < n_long; ++i) {
+      timings.start();
+      astar.find_path(grid, actors, random_floor(3, i), random_floor(4, i),
+                      path);
+      timings.stop();
+      checksum += path.size();
+    }
+    timings.report("A*" + name);
+  }
+
+  // The rest only count steps.
+  const BitGrid walkable = walkable_bits(grid);
+  Wavefront wavefront;
+  for (const auto& [pos, id] : actors) {
+    timings.start();
+    wavefront.generate(walkable, actors, pos, MOVE_RANGE);
+    timings.stop();
+    checksum += wavefront.size();
+  }
+  timings.report("move wavefront");
+
+  for (int i = 0; i < n_long; ++i) {
+    timings.start();
+    wavefront.generate(walkable, actors, actors[i % N_ACTORS].first);
+    timings.stop();
+    checksum += wavefront.size();
+  }
+  timings.report("full wavefront");
+
+  // The same trips as A*, with the units taken out of the bits to block the
+  // way, except for whoever is standing at either end.
+  BitGrid blocked = walkable;
+  for (const auto& [pos, id] : actors) blocked.set(pos, false);
+  JumpPointSearch jps;
+  for (int i = 0; i < n_long; ++i) {
+    glm::ivec2 start = random_floor(3, i), goal = random_floor(4, i);
+    blocked.set(start, true);
+    blocked.set(goal, true);
+    timings.start();
+    jps.find_path(blocked, start, goal, path);
+    timings.stop();
+    checksum += path.size();
+    for (const auto& [pos, id] : actors) blocked.set(pos, false);
+  }
+  timings.report("JPS");
+
+  // HPA* doesn't know about units, only terrain.
+  PathHierarchy hierarchy;
+  timings.start();
+  hierarchy.build(grid);
+  timings.stop();
+  timings.report("HPA* build");
+
+  std::vector<HierarchicalPath> plans(n_long);
+  for (int i = 0; i < n_long; ++i) {
+    timings.start();
+    hierarchy.plan(grid, random_floor(3, i), random_floor(4, i), plans[i]);
+    timings.stop();
+    checksum += plans[i].waypoints.size();
+  }
+  timings.report("HPA* plan");
+
+  // Just enough for one turn's move, which is all the CPU asks for.
+  for (HierarchicalPath& plan : plans) {
+    timings.start();
+    hierarchy.refine(grid, plan, MOVE_RANGE + 1);
+    timings.stop();
+    checksum += plan.tiles.size();
+  }
+  timings.report("HPA* refine turn");
+
+  for (HierarchicalPath& plan : plans) {
+    timings.start();
+    hierarchy.refine(grid, plan, std::numeric_limits<std::size_t>::max());
+    timings.stop();
+    checksum += plan.tiles.size();
+  }
+  timings.report("HPA* refine rest");
+  std::cout << "  checksum " << checksum << std::endl;
+}
+
+int main(int argc, char** argv) {
+  const int max_size = argc > 1 ? std::atoi(argv[1]) : 2048;
+
+  const Tile floor{.walkable = true, .glyph = MAP_FLOOR};
+  const Tile wall{.walkable = false, .opaque = true, .glyph = MAP_WALL};
+
+  for (int size : {64, 256, 1024, 2048}) {
+    if (size > max_size) break;
+    run("open " + std::to_string(size),
+        add_mud(arena_grid({size, size}, wall, floor)));
+
+    MapGenParams params;
+    params.dimensions = {size, size};
+    params.seed = 1234;
+    params.style = MapGenParams::ROOMS;
+    run("rooms " + std::to_string(size),
+        add_mud(generate_grid(params,
+                              {{MAP_FLOOR, floor}, {MAP_WALL, wall}})));
+
+    params.style = MapGenParams::CAVES;
+    run("caves " + std::to_string(size),
+        add_mud(generate_grid(params,
+                              {{MAP_FLOOR, floor}, {MAP_WALL, wall}})));
+  }
+}
@@ -0,0 +1,102 @@
+// Wavefront against DijkstraGrid counting steps on open arenas and caves, with
+// a few units standing around: time per fill over the whole map and within a
+// typical move range. Also checks that both reach as many tiles.
+//
+// Build with optimizations, e.g. `make benches CXXFLAGS=-O2`, and add
+// -mavx2 (or -march=native) to spread four words at a time instead of two.
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+#include "../dijkstra.h"
+#include "../mapgen.h"
+#include "../wavefront.h"
+#include "random.h"
+
+using Clock = std::chrono::high_resolution_clock;
+
+constexpr int N_SOURCES = 20;
+constexpr int N_UNITS = 50;
+constexpr unsigned int MOVE_RANGE = 6;
+
+static double us_since(Clock::time_point start) {
+  return std::chrono::duration<double, std::micro>(Clock::now() - start)
+    .count();
+}
+
+static void run(const std::string& label, const Grid& grid) {
+  std::vector<glm::ivec2> floors;
+  for (const auto& [pos, tile] : grid)
+    if (tile.walkable) floors.push_back(pos);
+  std::sort(floors.begin(), floors.end(), [](glm::ivec2 a, glm::ivec2 b) {
+    return a.y != b.y ? a.y < b.y : a.x < b.x;
+  });
+
+  std::vector<Occupant> units;
+  for (int i = 0; i < N_UNITS; ++i)
+    units.emplace_back(floors[hash_coords(1, i, 0) % floors.size()],
+                       EntityId{unsigned(i + 1)});
+  std::vector<glm::ivec2> sources;
+  for (int i = 0; i < N_SOURCES; ++i)
+    sources.push_back(floors[hash_coords(2, i, 0) % floors.size()]);
+
+  Clock::time_point start = Clock::now();
+  BitGrid walkable = walkable_bits(grid);
+  double bits_us = us_since(start);
+
+  std::cout << label << " (BitGrid built in " << bits_us << " us)\n";
+  for (unsigned int max_dist : {DijkstraGrid::UNBOUNDED, MOVE_RANGE}) {
+    DijkstraGrid dijkstra;
+    Wavefront wavefront;
+    // Once first so that neither pays for allocating its arrays.
+    dijkstra.generate(grid, units, sources[0], max_dist);
+    wavefront.generate(walkable, units, sources[0], max_dist);
+
+    std::size_t dijkstra_reached = 0;
+    start = Clock::now();
+    for (glm::ivec2 source : sources) {
+      dijkstra.generate(grid, units, source, max_dist);
+      dijkstra_reached += dijkstra.size();
+    }
+    double dijkstra_us = us_since(start);
+
+    std::size_t wavefront_reached = 0;
+    unsigned int steps = 0;
+    start = Clock::now();
+    for (glm::ivec2 source : sources) {
+      wavefront.generate(walkable, units, source, max_dist);
+      wavefront_reached += wavefront.size();
+      steps += wavefront.n_steps();
+    }
+    double wavefront_us = us_since(start);
+
+    if (max_dist == DijkstraGrid::UNBOUNDED)
+      std::cout << "  whole map, " << dijkstra_reached / N_SOURCES
+                << " tiles and " << steps / N_SOURCES << " steps per fill\n";
+    else
+      std::cout << "  within " << max_dist << "\n";
+    std::cout << "    DijkstraGrid: " << dijkstra_us / N_SOURCES << " us\n"
+              << "    Wavefront:    " << wavefront_us / N_SOURCES << " us";
+    if (dijkstra_reached != wavefront_reached)
+      std::cout << ", REACHED A DIFFERENT NUMBER OF TILES";
+    std::cout << std::endl;
+  }
+}
+
+int main() {
+  const Tile floor{.walkable = true, .glyph = MAP_FLOOR};
+  const Tile wall{.walkable = false, .opaque = true, .glyph = MAP_WALL};
+
+  for (int size : {64, 256, 1024}) {
+    run("arena " + std::to_string(size),
+        arena_grid({size, size}, wall, floor));
+
+    MapGenParams params;
+    params.style = MapGenParams::CAVES;
+    params.dimensions = {size, size};
+    params.seed = 1234;
+    run("caves " + std::to_string(size),
+        generate_grid(params, {{MAP_FLOOR, floor}, {MAP_WALL, wall}}));
+  }
+}
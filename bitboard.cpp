@@ -0,0 +1,31 @@
+#include "bitboard.h"
+
+BitGrid::BitGrid(glm::ivec2 min, glm::ivec2 size)
+  : min_(min), size_(size), words_per_row_((size.x + 63) / 64),
+    words_(std::size_t(words_per_row_) * size.y, 0) { }
+
+void BitGrid::set(glm::ivec2 p, bool value) {
+  if (!in_box(p)) return;
+  int x = p.x - min_.x;
+  std::uint64_t& w = words_[(p.y - min_.y) * words_per_row_ + x / 64];
+  const std::uint64_t bit = std::uint64_t(1) << (x % 64);
+  w = value ? w | bit : w & ~bit;
+}
+
+std::uint64_t BitGrid::bits_from(glm::ivec2 p) const {
+  const int row = p.y - min_.y;
+  const int x = p.x - min_.x;
+  // Round down, even for negative x, so the offset is always 0 to 63.
+  const int i = x >= 0 ? x / 64 : -((-x + 63) / 64);
+  const int offset = x - i * 64;
+  std::uint64_t bits = word(row, i) >> offset;
+  if (offset) bits |= word(row, i + 1) << (64 - offset);
+  return bits;
+}
+
+BitGrid walkable_bits(const Grid& grid) {
+  BitGrid bits(grid.bounds_min(), grid.bounds_max() - grid.bounds_min());
+  for (const auto& [pos, tile] : grid)
+    if (tile.walkable) bits.set(pos, true);
+  return bits;
+}
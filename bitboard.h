@@ -0,0 +1,78 @@
+#pragma once
+
+// One bit per tile, packed 64 to a word along each row, so that questions like
+// "where's the next wall to the right?" take a handful of instructions instead
+// of a hash lookup per tile.
+
+#include <bit>
+#include <cstdint>
+#include <vector>
+
+#include <glm/vec2.hpp>
+
+#include "grid.h"
+
+class BitGrid {
+  glm::ivec2 min_ = {0, 0};
+  glm::ivec2 size_ = {0, 0};
+  int words_per_row_ = 0;
+  std::vector<std::uint64_t> words_;
+
+  // Zero outside the box, so everything past the edge reads as unset.
+  std::uint64_t word(int row, int i) const {
+    if (row < 0 || row >= size_.y || i < 0 || i >= words_per_row_) return 0;
+    return words_[row * words_per_row_ + i];
+  }
+
+public:
+  BitGrid() = default;
+
+  // Covers the box [min, min + size) with every bit unset.
+  BitGrid(glm::ivec2 min, glm::ivec2 size);
+
+  glm::ivec2 min() const { return min_; }
+  glm::ivec2 size() const { return size_; }
+
+  bool in_box(glm::ivec2 p) const {
+    return p.x >= min_.x && p.y >= min_.y &&
+           p.x < min_.x + size_.x && p.y < min_.y + size_.y;
+  }
+
+  bool get(glm::ivec2 p) const {
+    if (!in_box(p)) return false;
+    int x = p.x - min_.x;
+    return words_[(p.y - min_.y) * words_per_row_ + x / 64] >> (x % 64) & 1;
+  }
+
+  // Does nothing outside the box.
+  void set(glm::ivec2 p, bool value);
+
+  // The 64 bits starting at p and going right: bit i is p + <i, 0>.
+  std::uint64_t bits_from(glm::ivec2 p) const;
+
+  // The 64 bits ending at p and coming from the left: bit 63 is p and bit
+  // 63 - i is p - <i, 0>.
+  std::uint64_t bits_until(glm::ivec2 p) const {
+    return bits_from(p - glm::ivec2(63, 0));
+  }
+
+  // Raw access to the words of a row, counting up from min().y, with the
+  // lowest bit of the first word at min().x.
+  int words_per_row() const { return words_per_row_; }
+  std::uint64_t* row(int y) { return &words_[y * words_per_row_]; }
+  const std::uint64_t* row(int y) const { return &words_[y * words_per_row_]; }
+
+  // Calls f(pos) for every set bit, row by row, skipping empty words.
+  template<typename F>
+  void for_each_set(F f) const {
+    for (int y = 0; y < size_.y; ++y) {
+      for (int i = 0; i < words_per_row_; ++i) {
+        for (std::uint64_t w = row(y)[i]; w; w &= w - 1)
+          f(min_ + glm::ivec2(i * 64 + std::countr_zero(w), y));
+      }
+    }
+  }
+};
+
+// A bit for every walkable tile, covering the grid's bounding box.
+BitGrid walkable_bits(const Grid& grid);
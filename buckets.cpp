@@ -0,0 +1,71 @@
+#include "buckets.h"
+
+#include "game.h"
+#include "math.h"
+
+void UnitBuckets::update(glm::ivec2 min, glm::ivec2 max,
+                         std::span<const Unit> units) {
+  min_ = min;
+  n_cells_ = glm::max((max - min + CELL - 1) / CELL, glm::ivec2(1, 1));
+  const std::size_t n_cells = std::size_t(n_cells_.x) * n_cells_.y;
+
+  for (auto& [team, buckets] : teams_) {
+    buckets.starts.assign(n_cells + 1, 0);
+    buckets.units.clear();
+  }
+
+  // A counting sort: count each cell, add up where each starts, then drop
+  // every unit into place.
+  cell_of_.resize(units.size());
+  for (std::size_t i = 0; i < units.size(); ++i) {
+    Buckets& buckets = teams_[units[i].team];
+    if (buckets.starts.size() != n_cells + 1)
+      buckets.starts.assign(n_cells + 1, 0);
+    cell_of_[i] = index(cell(units[i].pos));
+    ++buckets.starts[cell_of_[i] + 1];
+  }
+  for (auto& [team, buckets] : teams_) {
+    for (std::size_t c = 1; c <= n_cells; ++c)
+      buckets.starts[c] += buckets.starts[c - 1];
+    buckets.units.resize(buckets.starts[n_cells]);
+  }
+  // Each start is bumped along as its cell fills up, then put back after.
+  for (std::size_t i = 0; i < units.size(); ++i) {
+    Buckets& buckets = teams_[units[i].team];
+    buckets.units[buckets.starts[cell_of_[i]]++] = units[i];
+  }
+  for (auto& [team, buckets] : teams_) {
+    for (std::size_t c = n_cells; c > 0; --c)
+      buckets.starts[c] = buckets.starts[c - 1];
+    buckets.starts[0] = 0;
+  }
+}
+
+void UnitBuckets::update(const Game& game) {
+  std::vector<Unit> units;
+  for (const auto& [id, gpos, agent] :
+       game.ecs().read_all<GridPos, Agent>())
+    units.push_back({id, gpos.pos, agent.team});
+  update(game.grid().bounds_min(), game.grid().bounds_max(), units);
+}
+
+void UnitBuckets::enemies_within(Team team, glm::ivec2 pos,
+                                 unsigned int range,
+                                 std::vector<EntityId>& out) const {
+  out.clear();
+  const int r = range;
+  const glm::ivec2 first = cell(pos - r);
+  const glm::ivec2 last = cell(pos + r);
+  for (const auto& [other, buckets] : teams_) {
+    if (other == team) continue;
+    for (int y = first.y; y <= last.y; ++y) {
+      // A row of cells is one run of units.
+      const Unit* begin =
+        buckets.units.data() + buckets.starts[index({first.x, y})];
+      const Unit* end =
+        buckets.units.data() + buckets.starts[index({last.x, y}) + 1];
+      for (const Unit* u = begin; u != end; ++u)
+        if (diamond_dist(u->pos, pos) <= range) out.push_back(u->id);
+    }
+  }
+}
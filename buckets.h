@@ -0,0 +1,63 @@
+#pragma once
+
+// Who's near a tile, without asking every unit in the game. Units are sorted
+// into square cells of the map, one set of cells per team, so finding the
+// enemies within range of a tile only looks at the few cells around it.
+
+#include <map>
+#include <span>
+#include <vector>
+
+#include <glm/vec2.hpp>
+
+#include "components.h"
+
+class UnitBuckets {
+public:
+  // Tiles along each side of a cell. About a typical move plus attack range,
+  // so most queries look at a handful of cells.
+  static constexpr int CELL = 8;
+
+  struct Unit {
+    EntityId id;
+    glm::ivec2 pos;
+    Team team;
+  };
+
+private:
+  // Cells cover the box [min_, min_ + n_cells_ * CELL). Units outside it go
+  // in the nearest cell so that nobody's lost.
+  glm::ivec2 min_ = {0, 0};
+  glm::ivec2 n_cells_ = {0, 0};
+
+  // Each team's units, sorted by cell, and where each cell's run of them
+  // starts; the run ends where the next cell's starts.
+  struct Buckets {
+    std::vector<unsigned int> starts;
+    std::vector<Unit> units;
+  };
+  std::map<Team, Buckets> teams_;
+
+  // Scratch space for update().
+  std::vector<unsigned int> cell_of_;
+
+  glm::ivec2 cell(glm::ivec2 pos) const {
+    return glm::clamp((pos - min_) / CELL, glm::ivec2(0, 0),
+                      n_cells_ - glm::ivec2(1, 1));
+  }
+  unsigned int index(glm::ivec2 cell) const {
+    return cell.y * n_cells_.x + cell.x;
+  }
+
+public:
+  // Sorts everyone into cells over the box [min, max) from scratch. This is
+  // linear in the number of units and cells, and reuses the last call's
+  // memory.
+  void update(glm::ivec2 min, glm::ivec2 max, std::span<const Unit> units);
+  void update(const Game& game);
+
+  // Writes over `out` every unit not on `team` within `range` of `pos`, as
+  // counted by diamond_dist(), like can_attack().
+  void enemies_within(Team team, glm::ivec2 pos, unsigned int range,
+                      std::vector<EntityId>& out) const;
+};
@@ -0,0 +1,107 @@
+#include "combat.h"
+
+#include <algorithm>
+
+#include "game.h"
+#include "math.h"
+
+unsigned int attack_damage(const Stats& attacker, const Stats& defender,
+                           unsigned int defender_hp) {
+  // Signed, since a tough enough defender would otherwise take a huge hit.
+  int damage = int(attacker.strength) - int(defender.defense);
+  return std::min(unsigned(std::max(damage, 1)), defender_hp);
+}
+
+void change_hp(Actor& actor, int change, const StatusEffect& effect) {
+  if (effect.ticks_left > 0) actor.add_status(effect);
+  change = std::min(change, int(actor.hp));
+  actor.hp = std::min(unsigned(int(actor.hp) - change), actor.stats.max_hp);
+}
+
+AttackOutcome resolve_attack(const Ecs& ecs, const Grid& grid,
+                             AStar& path_finder, EntityId attacker,
+                             EntityId defender) {
+  const Actor& attacker_actor = ecs.read_or_panic<Actor>(attacker);
+  const Actor& defender_actor = ecs.read_or_panic<Actor>(defender);
+
+  AttackOutcome outcome;
+  outcome.attacker = attacker;
+  outcome.defender = defender;
+  outcome.damage = attack_damage(attacker_actor.stats, defender_actor.stats,
+                                 defender_actor.hp);
+  outcome.status = attacker_actor.embue;
+  if (attacker_actor.lifesteal)
+    outcome.healed = std::min(
+        outcome.damage,
+        attacker_actor.stats.max_hp -
+        std::min(attacker_actor.hp, attacker_actor.stats.max_hp));
+
+  if (attacker_actor.knockback) {
+    glm::ivec2 pos = ecs.read_or_panic<GridPos>(attacker).pos;
+    glm::ivec2 defender_pos = ecs.read_or_panic<GridPos>(defender).pos;
+    glm::ivec2 target_tile = defender_pos + (defender_pos - pos);
+
+    // Only knock them back if there's a straight shot with nobody in the way.
+    std::vector<Occupant> units;
+    for (const auto& [id, gpos, unused_actor] : ecs.read_all<GridPos, Actor>())
+      units.emplace_back(gpos.pos, id);
+    path_finder.find_path(grid, units, defender_pos, target_tile,
+                          outcome.knockback);
+    if (outcome.knockback.empty() ||
+        outcome.knockback.size() - 1 != manh_dist(defender_pos, target_tile) ||
+        std::any_of(units.begin(), units.end(), [&](const Occupant& unit) {
+          return unit.first == target_tile;
+        }))
+      outcome.knockback.clear();
+  }
+
+  return outcome;
+}
+
+AttackOutcome resolve_attack(const Game& game, EntityId attacker,
+                             EntityId defender) {
+  return resolve_attack(game.ecs(), game.grid(), game.path_finder(), attacker,
+                        defender);
+}
+
+void apply_damage(Ecs& ecs, const AttackOutcome& outcome) {
+  change_hp(ecs.read_or_panic<Actor>(outcome.defender), outcome.damage,
+            outcome.status);
+}
+
+void apply_lifesteal(Ecs& ecs, const AttackOutcome& outcome) {
+  if (outcome.healed)
+    change_hp(ecs.read_or_panic<Actor>(outcome.attacker), -int(outcome.healed),
+              StatusEffect());
+}
+
+void apply_knockback(Ecs& ecs, const AttackOutcome& outcome) {
+  if (!outcome.knockback.empty())
+    ecs.read_or_panic<GridPos>(outcome.defender).pos = outcome.knockback.back();
+}
+
+void apply_attack(Ecs& ecs, const AttackOutcome& outcome) {
+  apply_damage(ecs, outcome);
+  apply_lifesteal(ecs, outcome);
+  apply_knockback(ecs, outcome);
+}
+
+Resolution resolve_decision(const Ecs& ecs, const Grid& grid,
+                            AStar& path_finder, EntityId actor,
+                            const Decision& decision) {
+  Resolution resolution;
+  resolution.actor = actor;
+  resolution.decision = decision;
+  if (decision.type == Decision::ATTACK_ENTITY)
+    resolution.attack =
+      resolve_attack(ecs, grid, path_finder, actor, decision.target);
+  return resolution;
+}
+
+void apply_decision(Ecs& ecs, const Resolution& resolution) {
+  if (resolution.decision.type == Decision::MOVE_TO)
+    ecs.read_or_panic<GridPos>(resolution.actor).pos =
+      resolution.decision.move_to;
+  else if (resolution.decision.type == Decision::ATTACK_ENTITY)
+    apply_attack(ecs, resolution.attack);
+}
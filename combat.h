@@ -0,0 +1,63 @@
+#pragma once
+
+// The rules of a fight without the show. What an attack or any other decision
+// does is worked out up front, and then either applied all at once, for tests
+// and anything that wants to look ahead, or played out a step at a time by
+// push_attack() and friends. Both go through the same functions below, so
+// they can't disagree.
+
+#include <vector>
+
+#include <glm/vec2.hpp>
+
+#include "astar.h"
+#include "components.h"
+#include "decision.h"
+#include "grid.h"
+
+// How much `attacker` takes off of a defender with `defender_hp` left: the
+// difference in strength and defense, but at least one and no more than
+// they've got.
+unsigned int attack_damage(const Stats& attacker, const Stats& defender,
+                           unsigned int defender_hp);
+
+// Takes `change` off of the actor's hp, or gives it back if negative, keeping
+// it between zero and max_hp. `effect` is added if it lasts at all.
+void change_hp(Actor& actor, int change, const StatusEffect& effect);
+
+// Everything that changes when one unit hits another.
+struct AttackOutcome {
+  EntityId attacker;
+  EntityId defender;
+  unsigned int damage = 0;
+  StatusEffect status;      // The attacker's embue, put on the defender.
+  unsigned int healed = 0;  // Given back to the attacker by lifesteal.
+  // The defender's path away from the attacker, starting where they stand, if
+  // they get knocked back.
+  std::vector<glm::ivec2> knockback;
+};
+
+AttackOutcome resolve_attack(const Ecs& ecs, const Grid& grid,
+                             AStar& path_finder, EntityId attacker,
+                             EntityId defender);
+AttackOutcome resolve_attack(const Game& game, EntityId attacker,
+                             EntityId defender);
+
+// The parts of an outcome, in the order that push_attack() shows them.
+void apply_damage(Ecs& ecs, const AttackOutcome& outcome);
+void apply_lifesteal(Ecs& ecs, const AttackOutcome& outcome);
+void apply_knockback(Ecs& ecs, const AttackOutcome& outcome);
+
+void apply_attack(Ecs& ecs, const AttackOutcome& outcome);
+
+// What a decision comes to. Only moving and attacking change anything.
+struct Resolution {
+  EntityId actor;
+  Decision decision;
+  AttackOutcome attack;  // For ATTACK_ENTITY.
+};
+
+Resolution resolve_decision(const Ecs& ecs, const Grid& grid,
+                            AStar& path_finder, EntityId actor,
+                            const Decision& decision);
+void apply_decision(Ecs& ecs, const Resolution& resolution);
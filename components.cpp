@@ -13,3 +13,26 @@ const Script* Triggers::get_or_null(const std::string& name) const {
   auto it = scripts_.find(name);
   return it == std::end(scripts_) ? nullptr : &it->second;
 }
+
+int next_turn(std::span<const TurnTaker> takers, bool expire_statuses) {
+  int next = -1;
+  while (next < 0 || *takers[next].energy < ENERGY_REQUIRED) {
+    // Without speed or a status that might wear off, nothing will change.
+    bool changing = false;
+    for (std::size_t i = 0; i < takers.size(); ++i) {
+      const TurnTaker& t = takers[i];
+      if (expire_statuses && t.actor) {
+        t.actor->expire_statuses();
+        changing = changing || !t.actor->statuses.empty();
+      }
+      *t.energy += t.stats->speed;
+      changing = changing || t.stats->speed;
+      if (next < 0 || *t.energy > *takers[next].energy) next = i;
+    }
+    if (!changing && (next < 0 || *takers[next].energy < ENERGY_REQUIRED))
+      return -1;
+  }
+
+  *takers[next].energy -= ENERGY_REQUIRED;
+  return next;
+}
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <memory>
+#include <span>
+#include <utility>
 #include <vector>
 
 #include "ecs.h"
@@ -15,6 +17,9 @@ struct GridPos {
   glm::ivec2 pos;
 };
 
+// A unit standing on a tile, for path finding done without a Game.
+using Occupant = std::pair<glm::ivec2, EntityId>;
+
 // The graphical position of an entity in 2D/3D space. NOT RELATIVE TO THE
 // CAMERA POSITION. The integer value of pos' coordinates map to the same
 // location for a GridPos.
@@ -46,6 +51,7 @@ struct Stats {
   unsigned int defense = 3;
   unsigned int strength = 5;
   unsigned int speed = 5;
+  unsigned int sight = 12;
 };
 
 struct ScriptResult;
@@ -78,6 +84,7 @@ struct Actor {
   std::vector<StatusEffect> statuses;
   StatusEffect embue;
   bool lifesteal;
+  bool knockback;  // Pushes whoever it hits one tile further away.
 
   Triggers triggers;
 
@@ -88,6 +95,7 @@ struct Actor {
     stats.defense = base_stats.defense;
     stats.strength = base_stats.strength;
     stats.speed = base_stats.speed;
+    stats.sight = base_stats.sight;
 
     for (const StatusEffect& eff : statuses) {
       if (eff.slowed) stats.speed /= 2;
@@ -110,7 +118,8 @@ struct Actor {
   }
 
   Actor(std::string name, Stats stats)
-      : name(std::move(name)), base_stats(stats), lifesteal(false) {
+      : name(std::move(name)), base_stats(stats), lifesteal(false),
+        knockback(false) {
     hp = stats.max_hp;
     recalculate_stats();
   }
@@ -130,6 +139,23 @@ enum class Team { PLAYER, CPU };
 constexpr glm::vec4 PLAYER_COLOR = glm::vec4(.9f, .6f, .1f, 1.f);
 constexpr glm::vec4 CPU_COLOR = glm::vec4(0.f, 0.2f, 0.6f, 1.f);
 
+// How much energy an agent needs to take a turn; see
+// advance_until_next_turn() in main.cpp.
+constexpr int ENERGY_REQUIRED = 1000;
+
+// Someone waiting for a turn, for next_turn().
+struct TurnTaker {
+  int* energy;            // Agent::energy.
+  const Stats* stats;     // Read every tick, since statuses change speed.
+  Actor* actor = nullptr;  // Whose statuses wear off, if they do.
+};
+
+// The turn order of advance_until_next_turn() in main.cpp, for the game and
+// for anything simulating it: ticks until someone has ENERGY_REQUIRED, spends
+// it for whoever has the most, and returns their index. -1 if nobody ever
+// could. Statuses only wear off with `expire_statuses`.
+int next_turn(std::span<const TurnTaker> takers, bool expire_statuses);
+
 // The agent controls when an actor gets to take its turn and how.
 struct Agent {
   // TODO: When an agent is attacked, it should lose energy, but it should also
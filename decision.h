@@ -9,7 +9,6 @@
 
 // Forward decls due to mutual dependency.
 class Game;
-class DijkstraGrid;
 class UserInput;
 
 // Decides what actions to take for this turn.
@@ -33,11 +32,11 @@ struct Decision {
   Decision() : type(DECIDING) { }
 };
 
-bool can_attack(const Game& game, glm::ivec2 from_pos,
+// The target must be within range and in the attacker's line of sight.
+bool can_attack(const Game& game, EntityId attacker,
                 unsigned int attack_range,
                 EntityId target);
 
-bool can_talk(const Game& game, glm::ivec2 from_pos, EntityId target);
+bool can_talk(const Game& game, EntityId speaker, EntityId target);
 
-void cpu_decision(Game& game, const DijkstraGrid& dijkstra, EntityId id);
 void player_decision(Game& game, EntityId id, const UserInput& input);
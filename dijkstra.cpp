@@ -1,56 +1,527 @@
 #include "dijkstra.h"
 
+#include <algorithm>
+
 #include "game.h"
 
-#include <deque>
+std::vector<Occupant> unit_positions(const Game& game) {
+  std::vector<Occupant> units;
+  for (const auto& [id, gpos, unused_actor] :
+       game.ecs().read_all<GridPos, Actor>())
+    units.emplace_back(gpos.pos, id);
+  return units;
+}
+
+void DijkstraGrid::generate(const Game& game, glm::ivec2 source,
+                            unsigned int max_dist) {
+  generate(game, std::span(&source, 1), max_dist);
+}
+
+void DijkstraGrid::generate(const Grid& grid,
+                            std::span<const Occupant> occupants,
+                            glm::ivec2 source, unsigned int max_dist) {
+  generate(grid, occupants, std::span(&source, 1), max_dist);
+}
+
+void DijkstraGrid::generate(const Game& game,
+                            std::span<const glm::ivec2> sources,
+                            unsigned int max_dist) {
+  generate(game.grid(), unit_positions(game), sources, max_dist);
+  versioned_ = true;
+  grid_version_ = game.grid().version();
+  occupancy_version_ = game.occupancy_version();
+}
+
+void DijkstraGrid::generate(const Grid& grid,
+                            std::span<const Occupant> occupants,
+                            std::span<const glm::ivec2> sources,
+                            unsigned int max_dist) {
+  start(grid, occupants, sources, max_dist);
+  while (expand_next(grid, max_dist)) { }
+  finish(occupants);
+}
+
+void DijkstraGrid::start(const Grid& grid,
+                         std::span<const Occupant> occupants,
+                         std::span<const glm::ivec2> sources,
+                         unsigned int max_dist) {
+  sources_.assign(sources.begin(), sources.end());
+  max_dist_ = max_dist;
+  complete_ = true;
+  patched_ = false;
+  versioned_ = false;
+  grid_min_ = grid.bounds_min();
+  grid_max_ = grid.bounds_max();
+  min_ = grid_min_;
+  glm::ivec2 max = grid_max_;
+  if (max_dist < UNBOUNDED && !sources.empty()) {
+    // Every step costs at least one, so nothing further than max_dist along
+    // either axis from some source can be reached.
+    glm::ivec2 lo = sources.front(), hi = sources.front();
+    for (glm::ivec2 source : sources) {
+      lo = glm::min(lo, source);
+      hi = glm::max(hi, source);
+    }
+    const int reach = std::min<unsigned int>(max_dist, 1 << 20);
+    min_ = glm::max(min_, lo - reach);
+    max = glm::min(max, hi + reach + 1);
+  }
+  size_ = glm::max(max - min_, glm::ivec2(0, 0));
+
+  const std::size_t area = std::size_t(size_.x) * size_.y;
+  if (nodes_.size() < area) {
+    nodes_.resize(area);
+    occupant_.resize(area);
+  }
+  reached_.assign((area + 63) / 64, 0);
+  order_.clear();
+  head_ = 0;
+
+  if (costs_ == PathCosts::MOVE_COST) {
+    buckets_.resize(std::numeric_limits<decltype(Tile::move_cost)>::max() + 1);
+    for (auto& bucket : buckets_) bucket.clear();
+    bucket_dist_ = 0;
+    n_waiting_ = 0;
+  }
+
+  for (const auto& [pos, id] : occupants)
+    if (in_box(pos) && !occupant_[index(pos)]) occupant_[index(pos)] = id;
+
+  for (glm::ivec2 source : sources) {
+    auto [tile, exists] = grid.get(source);
+    if (in_box(source) && exists && tile.walkable && !reached(index(source)))
+      reach(index(source), {0, 0}, 0);
+  }
+}
 
-void DijkstraGrid::generate(const Game& game, glm::ivec2 source) {
-  nodes_.clear();
+void DijkstraGrid::reach(unsigned int i, glm::ivec2 prev, unsigned int dist) {
+  reached_[i / 64] |= std::uint64_t(1) << (i % 64);
+  nodes_[i] = DijkstraNode{prev, dist, occupant_[i]};
+  if (costs_ == PathCosts::STEPS) {
+    order_.push_back(i);
+  } else {
+    buckets_[dist % buckets_.size()].push_back(i);
+    ++n_waiting_;
+  }
+}
 
-  source_ = source;
+bool DijkstraGrid::expand_next(const Grid& grid, unsigned int max_dist) {
+  unsigned int i;
+  if (costs_ == PathCosts::STEPS) {
+    if (head_ == order_.size()) return false;
+    i = order_[head_++];
+  } else {
+    if (!n_waiting_) return false;
+    while (buckets_[bucket_dist_ % buckets_.size()].empty()) ++bucket_dist_;
+    std::vector<unsigned int>& bucket =
+      buckets_[bucket_dist_ % buckets_.size()];
+    i = bucket.back();
+    bucket.pop_back();
+    --n_waiting_;
+    order_.push_back(i);
+  }
 
   // Note that while we're creating a data structure that resembles the result
-  // of Dijkstra's algorithm, we're actually going to use flood fill because
-  // it's faster on simple 2D grids like this where all edge weights are the
-  // same.
-  struct QueNode { glm::ivec2 pos; glm::ivec2 prev; unsigned int dist; };
-  std::deque<QueNode> Q;
-  Q.push_back({source, {0, 0}, 0});
+  // of Dijkstra's algorithm, when counting steps we're actually going to use
+  // flood fill because it's faster on simple 2D grids like this where all
+  // edge weights are the same. Either way, the cost of an edge only depends on
+  // the tile it leads to, so the first time a tile is reached is also the
+  // cheapest and it never needs to be queued twice.
+  const DijkstraNode& node = nodes_[i];
+  if ((node.dist > 0 && node.entity) || node.dist >= max_dist) return true;
+
+  const glm::ivec2 pos = position(i);
+  for (glm::ivec2 next_pos : adjacent_positions(pos)) {
+    if (!in_box(next_pos)) continue;
+    const unsigned int next = index(next_pos);
+    if (reached(next)) continue;
+    auto [tile, exists] = grid.get(next_pos);
+    if (!exists || !tile.walkable) continue;
+
+    const unsigned int dist = node.dist + step_cost(tile);
+    if (dist <= max_dist) reach(next, pos, dist);
+  }
+  return true;
+}
 
-  while (!Q.empty()) {
-    auto [pos, prev, dist] = Q.front();
-    Q.pop_front();
+void DijkstraGrid::finish(std::span<const Occupant> occupants) {
+  for (const auto& [pos, id] : occupants)
+    if (in_box(pos)) occupant_[index(pos)] = EntityId();
+}
+
+std::size_t DijkstraGrid::repair(const Grid& grid,
+                                 std::span<const Occupant> occupants,
+                                 std::span<const glm::ivec2> changed) {
+  // Sources that were left out for not being walkable might be now, and the
+  // other way around, so either way it's simpler to start over.
+  bool same_sources = true;
+  for (glm::ivec2 source : sources_) {
+    auto [tile, exists] = grid.get(source);
+    same_sources = same_sources && exists && tile.walkable &&
+                   in_box(source) && reached(index(source));
+  }
+  if (!complete_ || !same_sources || grid.bounds_min() != grid_min_ ||
+      grid.bounds_max() != grid_max_) {
+    // Copied since generate() overwrites it.
+    std::vector<glm::ivec2> sources = sources_;
+    generate(grid, occupants, sources, max_dist_);
+    touched_.clear();
+    return n_touched_ = size();
+  }
+
+  for (const auto& [pos, id] : occupants)
+    if (in_box(pos) && !occupant_[index(pos)]) occupant_[index(pos)] = id;
+
+  // First, forget every changed tile and everything whose path ran through
+  // one. What's left still has a path as short as it says it does, though
+  // maybe not the shortest any more. Sources, the only tiles at a distance of
+  // zero, stay put no matter what.
+  invalid_.clear();
+  for (glm::ivec2 pos : changed) {
+    if (!in_box(pos)) continue;
+    if (reached(index(pos)) && nodes_[index(pos)].dist == 0) {
+      nodes_[index(pos)].entity = occupant_[index(pos)];
+      continue;
+    }
+    const std::size_t first = invalid_.size();
+    invalid_.push_back(index(pos));
+    if (reached(index(pos))) set_reached(index(pos), false);
+    for (std::size_t j = first; j < invalid_.size(); ++j) {
+      const glm::ivec2 prev = position(invalid_[j]);
+      for (glm::ivec2 next_pos : adjacent_positions(prev)) {
+        if (!in_box(next_pos)) continue;
+        const unsigned int next = index(next_pos);
+        if (reached(next) && nodes_[next].prev == prev &&
+            nodes_[next].dist != 0) {
+          set_reached(next, false);
+          invalid_.push_back(next);
+        }
+      }
+    }
+  }
 
-    auto [tile, exists] = game.grid().get(pos);
-    if (!exists || !tile.walkable || nodes_.contains(pos)) continue;
+  // Each forgotten tile starts from its best neighbour that's still known...
+  auto expands = [&](unsigned int i) {
+    const DijkstraNode& node = nodes_[i];
+    return (node.dist == 0 || !node.entity) && node.dist < max_dist_;
+  };
+  auto later = [](const auto& a, const auto& b) { return a.first > b.first; };
+  heap_.clear();
+  touched_.clear();
+  for (unsigned int i : invalid_) {
+    const glm::ivec2 pos = position(i);
+    touched_.push_back(pos);
+    auto [tile, exists] = grid.get(pos);
+    if (reached(i) || !exists || !tile.walkable) continue;
+    unsigned int best = UNBOUNDED;
+    glm::ivec2 best_prev;
+    for (glm::ivec2 prev : adjacent_positions(pos)) {
+      if (!in_box(prev) || !reached(index(prev)) || !expands(index(prev)))
+        continue;
+      const unsigned int dist = nodes_[index(prev)].dist + step_cost(tile);
+      if (dist < best) {
+        best = dist;
+        best_prev = prev;
+      }
+    }
+    if (best > max_dist_) continue;
+    set_reached(i, true);
+    nodes_[i] = DijkstraNode{best_prev, best, occupant_[i]};
+    heap_.emplace_back(best, i);
+  }
+  std::make_heap(heap_.begin(), heap_.end(), later);
 
-    nodes_[pos] = DijkstraNode{prev, dist, actor_at(game.ecs(), pos).first};
+  // ...and from there it's Dijkstra's algorithm, except that a tile already
+  // reached is only taken over when the new path is shorter. Stale entries
+  // are skipped rather than removed from the heap.
+  n_touched_ = invalid_.size();
+  while (!heap_.empty()) {
+    std::pop_heap(heap_.begin(), heap_.end(), later);
+    auto [dist, i] = heap_.back();
+    heap_.pop_back();
+    if (!reached(i) || nodes_[i].dist != dist || !expands(i)) continue;
+    ++n_touched_;
 
-    if (pos == source || !nodes_[pos].entity)
-      for (glm::ivec2 next_pos : adjacent_positions(pos))
-        Q.push_back({next_pos, pos, dist + 1});
+    const glm::ivec2 pos = position(i);
+    for (glm::ivec2 next_pos : adjacent_positions(pos)) {
+      if (!in_box(next_pos)) continue;
+      auto [tile, exists] = grid.get(next_pos);
+      if (!exists || !tile.walkable) continue;
+      const unsigned int next = index(next_pos);
+      const unsigned int next_dist = dist + step_cost(tile);
+      if (next_dist > max_dist_ ||
+          (reached(next) && nodes_[next].dist <= next_dist))
+        continue;
+      set_reached(next, true);
+      nodes_[next] = DijkstraNode{pos, next_dist, occupant_[next]};
+      touched_.push_back(next_pos);
+      heap_.emplace_back(next_dist, next);
+      std::push_heap(heap_.begin(), heap_.end(), later);
+    }
   }
+
+  finish(occupants);
+  rebuild_order();
+  patched_ = true;
+  return n_touched_;
 }
 
-std::vector<glm::ivec2> ipath_to(const DijkstraGrid& dijkstra,
-                                 glm::ivec2 pos) {
-  const DijkstraNode* node = &dijkstra.at(pos);
+bool DijkstraGrid::refresh(const Game& game, glm::ivec2 source,
+                           unsigned int max_dist) {
+  return refresh(game, std::span(&source, 1), max_dist);
+}
 
-  std::vector<glm::ivec2> path;
-  path.resize(node->dist + 1);
-  path[node->dist] = pos;
-  while (node->dist) {
+bool DijkstraGrid::refresh(const Game& game,
+                           std::span<const glm::ivec2> sources,
+                           unsigned int max_dist) {
+  return refresh(game.grid(), unit_positions(game),
+                 game.occupancy_changes_since(occupancy_version_),
+                 game.occupancy_version(), sources, max_dist);
+}
+
+bool DijkstraGrid::refresh(const Grid& grid,
+                           std::span<const Occupant> occupants,
+                           std::span<const glm::ivec2> occupancy_changes,
+                           unsigned int occupancy_version,
+                           std::span<const glm::ivec2> sources,
+                           unsigned int max_dist) {
+  // The version that the first of the changes led away from.
+  const unsigned int changes_from =
+    occupancy_version - std::min<unsigned int>(occupancy_changes.size(),
+                                               occupancy_version);
+  if (!versioned_ || max_dist != max_dist_ ||
+      occupancy_version_ < changes_from ||
+      occupancy_version_ > occupancy_version ||
+      !std::equal(sources.begin(), sources.end(),
+                  sources_.begin(), sources_.end())) {
+    generate(grid, occupants, sources, max_dist);
+    set_versions(grid.version(), occupancy_version);
+    return false;
+  }
+
+  std::vector<glm::ivec2> changed;
+  for (glm::ivec2 pos : grid.changes_since(grid_version_))
+    changed.push_back(pos);
+  for (glm::ivec2 pos :
+       occupancy_changes.subspan(occupancy_version_ - changes_from))
+    changed.push_back(pos);
+  // generate() clears this if repair() gives up and starts over.
+  patched_ = true;
+  touched_.clear();
+  if (!changed.empty()) repair(grid, occupants, changed);
+
+  set_versions(grid.version(), occupancy_version);
+  return patched_;
+}
+
+bool DijkstraGrid::up_to_date(const Game& game) const {
+  return up_to_date(game.grid(), game.occupancy_version());
+}
+
+bool DijkstraGrid::up_to_date(const Grid& grid,
+                              unsigned int occupancy_version) const {
+  return versioned_ && grid_version_ == grid.version() &&
+         occupancy_version_ == occupancy_version;
+}
+
+std::size_t DijkstraGrid::bytes() const {
+  std::size_t total = nodes_.capacity() * sizeof(DijkstraNode) +
+                      occupant_.capacity() * sizeof(EntityId) +
+                      (reached_.capacity() * sizeof(std::uint64_t)) +
+                      (order_.capacity() + invalid_.capacity()) *
+                      sizeof(unsigned int) +
+                      heap_.capacity() * sizeof(heap_[0]) +
+                      sources_.capacity() * sizeof(glm::ivec2);
+  for (const auto& bucket : buckets_)
+    total += bucket.capacity() * sizeof(unsigned int);
+  return total;
+}
+
+void DijkstraGrid::set_versions(unsigned int grid_version,
+                                unsigned int occupancy_version) {
+  versioned_ = true;
+  grid_version_ = grid_version;
+  occupancy_version_ = occupancy_version;
+}
+
+void DijkstraGrid::rebuild_order() {
+  order_.clear();
+  const unsigned int area = size_.x * size_.y;
+  for (unsigned int i = 0; i < area; ++i)
+    if (reached(i)) order_.push_back(i);
+  std::stable_sort(order_.begin(), order_.end(),
+                   [&](unsigned int a, unsigned int b) {
+                     return nodes_[a].dist < nodes_[b].dist;
+                   });
+}
+
+const DijkstraGrid& FieldCache::get(const Game& game, glm::ivec2 source,
+                                    unsigned int max_dist) {
+  // Only what changed since the field was last brought up to date.
+  unsigned int since = game.occupancy_version();
+  if (auto found = index_.find(glm::ivec3(source, max_dist));
+      found != index_.end())
+    since = found->second->field.occupancy_version();
+  return get(game.grid(), unit_positions(game),
+             game.occupancy_changes_since(since), game.occupancy_version(),
+             source, max_dist);
+}
+
+const DijkstraGrid& FieldCache::get(const Grid& grid,
+                                    std::span<const Occupant> occupants,
+                                    std::span<const glm::ivec2> changes,
+                                    unsigned int occupancy_version,
+                                    glm::ivec2 source,
+                                    unsigned int max_dist) {
+  const glm::ivec3 key(source, max_dist);
+  if (auto found = index_.find(key); found != index_.end()) {
+    entries_.splice(entries_.begin(), entries_, found->second);
+    DijkstraGrid& field = entries_.front().field;
+    if (field.up_to_date(grid, occupancy_version)) {
+      ++n_hits_;
+    } else {
+      field.refresh(grid, occupants, changes, occupancy_version,
+                    std::span(&source, 1), max_dist);
+      ++n_repairs_;
+    }
+    return field;
+  }
+
+  ++n_misses_;
+  if (!entries_.empty() && bytes() >= budget_) {
+    // Full, so recycle the least recently used.
+    index_.erase(entries_.back().key());
+    entries_.splice(entries_.begin(), entries_, std::prev(entries_.end()));
+    entries_.front().source = source;
+    entries_.front().max_dist = max_dist;
+  } else {
+    entries_.push_front(Entry{source, max_dist, DijkstraGrid(costs_)});
+  }
+  index_[key] = entries_.begin();
+  entries_.front().field.generate(grid, occupants, source, max_dist);
+  entries_.front().field.set_versions(grid.version(), occupancy_version);
+
+  // A big field might push out several small ones, though never itself.
+  while (entries_.size() > 1 && bytes() > budget_) {
+    index_.erase(entries_.back().key());
+    entries_.pop_back();
+  }
+  return entries_.front().field;
+}
+
+void FieldCache::adopt(glm::ivec2 source, unsigned int max_dist,
+                       DijkstraGrid field) {
+  const glm::ivec3 key(source, max_dist);
+  if (auto found = index_.find(key); found != index_.end()) {
+    entries_.splice(entries_.begin(), entries_, found->second);
+    entries_.front().field = std::move(field);
+  } else {
+    entries_.push_front(Entry{source, max_dist, std::move(field)});
+    index_[key] = entries_.begin();
+  }
+
+  while (entries_.size() > 1 && bytes() > budget_) {
+    index_.erase(entries_.back().key());
+    entries_.pop_back();
+  }
+}
+
+std::size_t FieldCache::bytes() const {
+  std::size_t total = 0;
+  for (const Entry& entry : entries_) total += entry.field.bytes();
+  return total;
+}
+
+FieldPrefetch::FieldPrefetch(PathCosts costs, unsigned int n_threads)
+  : costs_(costs),
+    n_threads_(n_threads ? n_threads
+                         : std::max(1u, std::thread::hardware_concurrency())) {
+}
+
+void FieldPrefetch::start(const Game& game,
+                          std::span<const Request> requests) {
+  start(game.grid(), unit_positions(game), requests);
+  versioned_ = true;
+  grid_version_ = game.grid().version();
+  occupancy_version_ = game.occupancy_version();
+}
+
+void FieldPrefetch::start(const Grid& grid,
+                          std::span<const Occupant> occupants,
+                          std::span<const Request> requests) {
+  wait();
+  requests_.assign(requests.begin(), requests.end());
+  occupants_.assign(occupants.begin(), occupants.end());
+  fields_.assign(requests_.size(), DijkstraGrid(costs_));
+  versioned_ = false;
+
+  // Requests are handed out one at a time, as in generate_map_chunks(), and
+  // each worker writes only to the fields it took. Unlike there, the calling
+  // thread doesn't help, since the point is to get on with the turn.
+  const unsigned int n_threads =
+    std::min<std::size_t>(n_threads_, requests_.size());
+  next_ = 0;
+  for (unsigned int t = 0; t < n_threads; ++t) {
+    threads_.emplace_back([this, &grid] {
+      for (std::size_t i; (i = next_++) < requests_.size();) {
+        fields_[i].generate(grid, occupants_, requests_[i].source,
+                            requests_[i].max_dist);
+      }
+    });
+  }
+}
+
+void FieldPrefetch::wait() {
+  for (std::thread& t : threads_) t.join();
+  threads_.clear();
+}
+
+void FieldPrefetch::hand_over(FieldCache& cache) {
+  wait();
+  for (std::size_t i = 0; i < fields_.size(); ++i) {
+    if (versioned_)
+      fields_[i].set_versions(grid_version_, occupancy_version_);
+    cache.adopt(requests_[i].source, requests_[i].max_dist,
+                std::move(fields_[i]));
+  }
+  requests_.clear();
+  fields_.clear();
+}
+
+// Distances aren't always steps, so walk back first and flip it after.
+template<typename Vec>
+static void walk_back(const DijkstraGrid& dijkstra, glm::ivec2 pos,
+                      std::vector<Vec>& path) {
+  path.clear();
+  path.emplace_back(pos);
+  for (const DijkstraNode* node = &dijkstra.at(pos); node->dist;
+       node = &dijkstra.at(pos)) {
     pos = node->prev;
-    node = &dijkstra.at(pos);
-    path[node->dist] = pos;
+    path.emplace_back(pos);
   }
+  std::reverse(path.begin(), path.end());
+}
 
+void ipath_to(const DijkstraGrid& dijkstra, glm::ivec2 pos,
+              std::vector<glm::ivec2>& path) {
+  walk_back(dijkstra, pos, path);
+}
+
+void path_to(const DijkstraGrid& dijkstra, glm::ivec2 pos,
+             std::vector<glm::vec2>& path) {
+  walk_back(dijkstra, pos, path);
+}
+
+std::vector<glm::ivec2> ipath_to(const DijkstraGrid& dijkstra,
+                                 glm::ivec2 pos) {
+  std::vector<glm::ivec2> path;
+  ipath_to(dijkstra, pos, path);
   return path;
 }
 
 std::vector<glm::vec2> path_to(const DijkstraGrid& dijkstra, glm::ivec2 pos) {
-  auto ipath = ipath_to(dijkstra, pos);
-  std::vector<glm::vec2> path(ipath.begin(), ipath.end());
+  std::vector<glm::vec2> path;
+  path_to(dijkstra, pos, path);
   return path;
 }
 
@@ -64,21 +535,30 @@ glm::ivec2 rewind(const DijkstraGrid& dijkstra, glm::ivec2 pos,
   return pos;
 }
 
-std::pair<const DijkstraNode*, glm::ivec2>
-nearest_enemy_location(const Game& game, const DijkstraGrid& dijkstra,
-                       EntityId my_id, Team my_team) {
-  const DijkstraNode* min_node = nullptr;
-  glm::ivec2 min_pos;
-  for (const auto& [id, gpos, agent] : game.ecs().read_all<GridPos, Agent>()) {
-    const glm::ivec2& pos = gpos.pos;
-    if (id != my_id && agent.team != my_team && pos != dijkstra.source()) {
-      const DijkstraNode& node = dijkstra.at(pos);
-      if (!min_node || node.dist < min_node->dist) {
-        min_node = &node;
-        min_pos = pos;
-      }
-    }
-  }
-  return {min_node, min_pos};
+std::vector<glm::ivec2> enemy_positions(const Game& game, Team team) {
+  std::vector<glm::ivec2> positions;
+  for (const auto& [id, gpos, agent] : game.ecs().read_all<GridPos, Agent>())
+    if (agent.team != team) positions.push_back(gpos.pos);
+  return positions;
 }
 
+glm::ivec2 descend(const DijkstraGrid& field, glm::ivec2 pos,
+                   unsigned int budget) {
+  if (!field.contains(pos)) return pos;
+  // Each node's distance counts the cost of entering it from its prev, which
+  // is the way we're going, so the cost of stepping onto `next` is its
+  // distance less that of its own prev.
+  const DijkstraNode* node = &field.at(pos);
+  unsigned int spent = 0;
+  while (node->dist > 0) {
+    const glm::ivec2 next = node->prev;
+    const DijkstraNode& next_node = field.at(next);
+    if (next_node.dist == 0 || next_node.entity) break;
+    const unsigned int cost = next_node.dist - field.at(next_node.prev).dist;
+    if (spent + cost > budget) break;
+    spent += cost;
+    pos = next;
+    node = &next_node;
+  }
+  return pos;
+}
@@ -1,9 +1,19 @@
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
 #include <limits>
+#include <list>
+#include <span>
+#include <thread>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
 
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtx/hash.hpp>
@@ -16,34 +26,365 @@ struct DijkstraNode {
   EntityId entity;
 };
 
+std::vector<Occupant> unit_positions(const Game& game);
+
 class DijkstraGrid {
-  std::unordered_map<glm::ivec2, DijkstraNode> nodes_;
-  glm::ivec2 source_;
+  PathCosts costs_;  // What `dist` counts.
+  std::vector<glm::ivec2> sources_;
+
+  // Everything is stored in flat arrays covering the box [min_, min_ + size_):
+  // the grid's bounding box, cut down to what a bounded flood could reach.
+  // nodes_[i] only means something once reached_ has bit i set.
+  glm::ivec2 min_ = {0, 0};
+  glm::ivec2 size_ = {0, 0};
+  std::vector<DijkstraNode> nodes_;
+  std::vector<std::uint64_t> reached_;
+
+  // Indices in order of distance. When counting steps, this doubles as the
+  // queue for the flood fill: nothing is added twice so it never needs to
+  // wrap around, and head_ is the next tile to expand. repair() rebuilds it
+  // before returning, so that reading a field never changes it.
+  std::vector<unsigned int> order_;
+  std::size_t head_ = 0;
+
+  // What the last generate() was asked for, so repair() can keep to it.
+  unsigned int max_dist_ = 0;
+  bool complete_ = false;  // False if generate_until() stopped early.
+
+  // For refresh(): the versions of the Game this is up to date with.
+  bool versioned_ = false;
+  unsigned int grid_version_ = 0;
+  unsigned int occupancy_version_ = 0;
+  glm::ivec2 grid_min_ = {0, 0};
+  glm::ivec2 grid_max_ = {0, 0};
+
+  // Scratch space for repair().
+  std::vector<unsigned int> invalid_;
+  std::vector<std::pair<unsigned int, unsigned int>> heap_;
+  std::vector<glm::ivec2> touched_;
+  std::size_t n_touched_ = 0;
+  bool patched_ = false;  // False once generate() starts over.
+
+  // With move costs, tiles wait in buckets by distance (Dial's algorithm).
+  // A tile never waits more than the highest move cost ahead of the one being
+  // expanded, so the buckets are used as a ring.
+  std::vector<std::vector<unsigned int>> buckets_;
+  unsigned int bucket_dist_ = 0;
+  std::size_t n_waiting_ = 0;
+
+  // Scratch space: who stands on each tile, only filled in for the tiles in
+  // `occupants` while generate() runs.
+  std::vector<EntityId> occupant_;
+
+  bool in_box(glm::ivec2 p) const {
+    return p.x >= min_.x && p.y >= min_.y &&
+           p.x < min_.x + size_.x && p.y < min_.y + size_.y;
+  }
+  unsigned int index(glm::ivec2 p) const {
+    return (p.y - min_.y) * size_.x + (p.x - min_.x);
+  }
+  glm::ivec2 position(unsigned int i) const {
+    return min_ + glm::ivec2(i % size_.x, i / size_.x);
+  }
+  bool reached(unsigned int i) const {
+    return reached_[i / 64] >> (i % 64) & 1;
+  }
+  void set_reached(unsigned int i, bool value) {
+    const std::uint64_t bit = std::uint64_t(1) << (i % 64);
+    reached_[i / 64] = value ? reached_[i / 64] | bit : reached_[i / 64] & ~bit;
+  }
+  unsigned int step_cost(const Tile& tile) const {
+    return costs_ == PathCosts::STEPS
+           ? 1 : std::max<unsigned int>(tile.move_cost, 1);
+  }
+  // Sorts every reached tile back into order_, after a repair().
+  void rebuild_order();
+
+  // The pieces of a flood fill: start() sets up the arrays and reaches the
+  // source, each call to expand_next() adds the next closest tile to order_
+  // (if it isn't there already) and reaches its neighbours, and finish() tidies
+  // up the scratch space.
+  void start(const Grid& grid, std::span<const Occupant> occupants,
+             std::span<const glm::ivec2> sources, unsigned int max_dist);
+  void reach(unsigned int i, glm::ivec2 prev, unsigned int dist);
+  bool expand_next(const Grid& grid, unsigned int max_dist);
+  void finish(std::span<const Occupant> occupants);
+
+public:
+  static constexpr unsigned int UNBOUNDED =
+    std::numeric_limits<unsigned int>::max();
+
+  // Counting move costs stays close to the speed of counting steps, but
+  // there's no point if every tile costs the same.
+  explicit DijkstraGrid(PathCosts costs = PathCosts::STEPS) : costs_(costs) { }
+
+  // Reaches every tile up to `max_dist` away. The work done is proportional
+  // to the area within that distance, not the size of the map.
+  void generate(const Game& game, glm::ivec2 source,
+                unsigned int max_dist = UNBOUNDED);
+
+  // For callers without a Game. If more than one unit claims a tile, the first
+  // one listed wins.
+  void generate(const Grid& grid, std::span<const Occupant> occupants,
+                glm::ivec2 source, unsigned int max_dist = UNBOUNDED);
+
+  // Floods from several sources at once, so each tile ends up with the
+  // distance to whichever is closest: e.g. every tile's distance to the
+  // nearest enemy. Sources that aren't walkable are left out.
+  void generate(const Game& game, std::span<const glm::ivec2> sources,
+                unsigned int max_dist = UNBOUNDED);
+  void generate(const Grid& grid, std::span<const Occupant> occupants,
+                std::span<const glm::ivec2> sources,
+                unsigned int max_dist = UNBOUNDED);
+
+  // Floods outward until `stop(pos, node)` is true for a tile just reached and
+  // returns that tile, which is as close as any other that would match.
+  // Returns false if the flood runs out first.
+  template<typename Pred>
+  std::pair<glm::ivec2, bool> generate_until(
+      const Grid& grid, std::span<const Occupant> occupants,
+      glm::ivec2 source, Pred stop) {
+    std::pair<glm::ivec2, bool> found = {source, false};
+    start(grid, occupants, std::span(&source, 1), UNBOUNDED);
+    std::size_t checked = 0;
+    do {
+      for (; checked < order_.size(); ++checked) {
+        glm::ivec2 pos = position(order_[checked]);
+        if (stop(pos, std::as_const(nodes_[order_[checked]]))) {
+          found = {pos, true};
+          break;
+        }
+      }
+    } while (!found.second && expand_next(grid, UNBOUNDED));
+    complete_ = !found.second;
+    finish(occupants);
+    return found;
+  }
+
+  template<typename Pred>
+  std::pair<glm::ivec2, bool> generate_until(const Game& game,
+                                             glm::ivec2 source, Pred stop) {
+    return generate_until(game.grid(), unit_positions(game), source, stop);
+  }
+
+  // Catches up on changes to the tiles in `changed`, whether to the grid or to
+  // who's standing on them, without starting over. Only tiles whose distance
+  // depended on those are looked at again, which after a unit takes a step is
+  // usually a small part of the field. Returns how many tiles were touched.
+  //
+  // A field from generate_until() that stopped early can't be repaired and is
+  // generated again instead.
+  std::size_t repair(const Grid& grid, std::span<const Occupant> occupants,
+                     std::span<const glm::ivec2> changed);
+
+  // Repairs the field if it already comes from the same sources in this game
+  // with the same max_dist, and generates it otherwise. Returns true if it was
+  // only repaired, or nothing had changed.
+  bool refresh(const Game& game, glm::ivec2 source,
+               unsigned int max_dist = UNBOUNDED);
+  bool refresh(const Game& game, std::span<const glm::ivec2> sources,
+               unsigned int max_dist = UNBOUNDED);
+
+  // For callers without a Game. `occupancy_changes` are the last tiles to
+  // change hands up to `occupancy_version`, as from
+  // Game::occupancy_changes_since(). Only those since the field's own
+  // occupancy_version() are needed; if they don't go back that far, the field
+  // starts over.
+  bool refresh(const Grid& grid, std::span<const Occupant> occupants,
+               std::span<const glm::ivec2> occupancy_changes,
+               unsigned int occupancy_version,
+               std::span<const glm::ivec2> sources,
+               unsigned int max_dist = UNBOUNDED);
+
+  // How many tiles the last repair() touched.
+  std::size_t n_touched() const { return n_touched_; }
+
+  // The tiles whose nodes the last repair() may have changed, some maybe more
+  // than once. Empty if it had to start over.
+  std::span<const glm::ivec2> touched() const { return touched_; }
+
+  // False if the last repair() or refresh() had to start over, in which case
+  // touched() is no help.
+  bool patched() const { return patched_; }
+
+  // True if this was generated or refreshed from `game` and nothing has moved
+  // or changed since.
+  bool up_to_date(const Game& game) const;
+  bool up_to_date(const Grid& grid, unsigned int occupancy_version) const;
+
+  // Roughly how much memory the field is holding on to.
+  std::size_t bytes() const;
+
+  // Marks the field as up to date with a game at these versions, for fields
+  // generated from a copy of where its units stood.
+  void set_versions(unsigned int grid_version, unsigned int occupancy_version);
+  unsigned int occupancy_version() const { return occupancy_version_; }
+
+  // The first source, for fields that only have one.
+  const glm::ivec2& source() const { return sources_.front(); }
+  std::span<const glm::ivec2> sources() const { return sources_; }
+
+  // Unchecked but for the assert, so check contains() first.
+  DijkstraNode& at(glm::ivec2 pos) {
+    assert(contains(pos));
+    return nodes_[index(pos)];
+  }
+  const DijkstraNode& at(glm::ivec2 pos) const {
+    assert(contains(pos));
+    return nodes_[index(pos)];
+  }
+
+  bool contains(glm::ivec2 p) const { return in_box(p) && reached(index(p)); }
+
+  // The number of tiles reached.
+  std::size_t size() const { return order_.size(); }
+
+  // Iterates over (position, node) pairs in order of distance.
+  class iterator {
+    const DijkstraGrid* dijkstra_;
+    const unsigned int* i_;
+
+  public:
+    iterator(const DijkstraGrid* d, const unsigned int* i)
+      : dijkstra_(d), i_(i) { }
+
+    std::pair<glm::ivec2, const DijkstraNode&> operator*() const {
+      return {dijkstra_->position(*i_), dijkstra_->nodes_[*i_]};
+    }
+    iterator& operator++() { ++i_; return *this; }
+    bool operator==(const iterator& other) const { return i_ == other.i_; }
+    bool operator!=(const iterator& other) const { return i_ != other.i_; }
+  };
+
+  iterator begin() const { return {this, order_.data()}; }
+  iterator end() const { return {this, order_.data() + order_.size()}; }
+};
+
+// Keeps the most recently used fields, so a unit that gets two turns in a row
+// or comes back to the same tile doesn't flood again. Fields are looked up by
+// source and max_dist. One that's out of date is repaired rather than thrown
+// away. When the fields add up to more than the budget, the least recently
+// used are dropped, and a new field reuses the buffers of the one it replaces.
+//
+// Units moving only counts once Game::track_occupancy() has seen it.
+class FieldCache {
+  struct Entry {
+    glm::ivec2 source;
+    unsigned int max_dist;
+    DijkstraGrid field;
+
+    glm::ivec3 key() const { return glm::ivec3(source, max_dist); }
+  };
+
+  PathCosts costs_;
+  std::size_t budget_;
+  std::list<Entry> entries_;  // Most recently used first.
+  // Keyed by (source, max_dist).
+  std::unordered_map<glm::ivec3, std::list<Entry>::iterator> index_;
+
+  unsigned int n_hits_ = 0;
+  unsigned int n_repairs_ = 0;
+  unsigned int n_misses_ = 0;
 
 public:
-  void generate(const Game& game, glm::ivec2 source);
+  FieldCache(PathCosts costs, std::size_t budget_bytes)
+    : costs_(costs), budget_(budget_bytes) { }
 
-  const glm::ivec2& source() const { return source_; }
+  // The reference stays good until the next call to get() or adopt().
+  const DijkstraGrid& get(const Game& game, glm::ivec2 source,
+                          unsigned int max_dist = DijkstraGrid::UNBOUNDED);
+  // For callers without a Game, with occupancy changes as for
+  // DijkstraGrid::refresh().
+  const DijkstraGrid& get(const Grid& grid,
+                          std::span<const Occupant> occupants,
+                          std::span<const glm::ivec2> occupancy_changes,
+                          unsigned int occupancy_version,
+                          glm::ivec2 source,
+                          unsigned int max_dist = DijkstraGrid::UNBOUNDED);
 
-  DijkstraNode& at(glm::ivec2 pos) { return nodes_.at(pos); }
-  const DijkstraNode& at(glm::ivec2 pos) const { return nodes_.at(pos); }
+  // Takes a field generated elsewhere, replacing any from the same source
+  // with the same max_dist.
+  void adopt(glm::ivec2 source, unsigned int max_dist, DijkstraGrid field);
 
-  bool contains(glm::ivec2 p) { return nodes_.contains(p); }
+  void clear() {
+    entries_.clear();
+    index_.clear();
+  }
+
+  std::size_t size() const { return entries_.size(); }
+  std::size_t bytes() const;
+
+  // Fields that were up to date, that needed repair, and that had to be
+  // generated from scratch.
+  unsigned int n_hits() const { return n_hits_; }
+  unsigned int n_repairs() const { return n_repairs_; }
+  unsigned int n_misses() const { return n_misses_; }
+};
+
+// Generates fields on worker threads, e.g. for every actor while the current
+// one takes its turn, so they're ready by the time they're needed.
+//
+// The workers work from a copy of where every unit stood, so units can move
+// freely in the meantime, but they read the grid itself: nothing may change
+// it until wait() returns.
+class FieldPrefetch {
+public:
+  struct Request {
+    glm::ivec2 source;
+    unsigned int max_dist = DijkstraGrid::UNBOUNDED;
+  };
+
+private:
+  PathCosts costs_;
+  unsigned int n_threads_;
+
+  std::vector<Request> requests_;
+  std::vector<DijkstraGrid> fields_;  // One for each request, once done.
+  std::vector<Occupant> occupants_;
+  bool versioned_ = false;
+  unsigned int grid_version_ = 0;
+  unsigned int occupancy_version_ = 0;
 
-  auto begin() { return nodes_.begin(); }
-  auto begin() const { return nodes_.begin(); }
-  auto end() { return nodes_.end(); }
-  auto end() const { return nodes_.end(); }
+  std::vector<std::thread> threads_;
+  std::atomic<std::size_t> next_ = 0;  // The next request to take.
+
+public:
+  // With no n_threads, uses one per core.
+  explicit FieldPrefetch(PathCosts costs, unsigned int n_threads = 0);
+  ~FieldPrefetch() { wait(); }
+
+  // Waits for anything already running, then starts on these.
+  void start(const Game& game, std::span<const Request> requests);
+  void start(const Grid& grid, std::span<const Occupant> occupants,
+             std::span<const Request> requests);
+
+  // Blocks until every field is done.
+  void wait();
+
+  // After wait(), the field for each request, in the order they were made.
+  std::size_t size() const { return fields_.size(); }
+  const DijkstraGrid& field(std::size_t i) const { return fields_[i]; }
+
+  // Waits, then moves every field into `cache`.
+  void hand_over(FieldCache& cache);
 };
 
 // Returns the path to a position. Use ipath_to() for the format most native to
 // the dijkstra graph, integers, and path_to() for the type most native to
-// rendering: floats.
+// rendering: floats. `pos` must be in the field; see contains().
 std::vector<glm::ivec2> ipath_to(const DijkstraGrid& dijkstra, glm::ivec2 pos);
 std::vector<glm::vec2> path_to(const DijkstraGrid& dijkstra, glm::ivec2 pos);
 
+// The same, written over `path` so that its memory can be reused. See also
+// PathPool.
+void ipath_to(const DijkstraGrid& dijkstra, glm::ivec2 pos,
+              std::vector<glm::ivec2>& path);
+void path_to(const DijkstraGrid& dijkstra, glm::ivec2 pos,
+             std::vector<glm::vec2>& path);
+
 // Roll down the graph n times. If n is larger that the distance from pos to
-// the source(), source() is returned.
+// the source(), source() is returned. As for ipath_to(), `pos` must be in the
+// field.
 glm::ivec2 rewind(const DijkstraGrid& dijkstra, glm::ivec2 pos,
                   unsigned int n);
 
@@ -60,7 +401,14 @@ glm::ivec2 rewind_until(const DijkstraGrid& dijkstra, glm::ivec2 pos,
   return pos;
 }
 
-// Returns the location of the closest attacking target for AI.
-std::pair<const DijkstraNode*, glm::ivec2>
-nearest_enemy_location(const Game& game, const DijkstraGrid& dijkstra,
-                       EntityId my_id, Team my_team);
+// Where every unit not on `team` stands, for a field of distances to the
+// nearest enemy.
+std::vector<glm::ivec2> enemy_positions(const Game& game, Team team);
+
+// Follows a field downhill from `pos` toward the nearest source, as far as a
+// unit there could walk for `budget`, and returns where it ends up. It stops
+// short of the source itself and of anyone in the way. With a field from
+// enemy_positions(), that's the best place to move to in order to close in on
+// an enemy.
+glm::ivec2 descend(const DijkstraGrid& field, glm::ivec2 pos,
+                   unsigned int budget);
@@ -0,0 +1,86 @@
+#include "flow.h"
+
+#include <algorithm>
+#include <tuple>
+
+void FlowField::generate(const Grid& grid, std::span<const glm::ivec2> goals,
+                         std::span<const Occupant> occupants) {
+  integration_.generate(grid, occupants, goals);
+  update_all(grid);
+}
+
+void FlowField::generate(const Game& game,
+                         std::span<const glm::ivec2> goals) {
+  integration_.generate(game, goals);
+  update_all(game.grid());
+}
+
+void FlowField::repair(const Grid& grid, std::span<const Occupant> occupants,
+                       std::span<const glm::ivec2> changed) {
+  integration_.repair(grid, occupants, changed);
+  if (!integration_.patched()) {
+    update_all(grid);
+    return;
+  }
+  for (glm::ivec2 pos : integration_.touched()) update_step(pos);
+}
+
+void FlowField::refresh(const Game& game,
+                        std::span<const glm::ivec2> goals) {
+  if (!integration_.refresh(game, goals)) {
+    update_all(game.grid());
+    return;
+  }
+  for (glm::ivec2 pos : integration_.touched()) update_step(pos);
+}
+
+void FlowField::update_step(glm::ivec2 pos) {
+  if (!in_box(pos)) return;
+  std::uint8_t& step = steps_[index(pos)];
+  if (!integration_.contains(pos)) {
+    step = NO_WAY;
+    return;
+  }
+  const DijkstraNode& node = integration_.at(pos);
+  if (node.dist == 0) {
+    step = AT_GOAL;
+    return;
+  }
+  const auto steps = adjacent_steps();
+  step = std::find(steps.begin(), steps.end(), node.prev - pos) -
+         steps.begin();
+}
+
+void FlowField::update_all(const Grid& grid) {
+  min_ = grid.bounds_min();
+  size_ = glm::max(grid.bounds_max() - min_, glm::ivec2(0, 0));
+  steps_.assign(std::size_t(size_.x) * size_.y, NO_WAY);
+  for (const auto& [pos, node] : integration_) update_step(pos);
+}
+
+glm::ivec2 FlowField::follow(glm::ivec2 pos, unsigned int budget) const {
+  unsigned int spent = 0;
+  for (auto [next_pos, ok] = next(pos); ok && !at_goal(next_pos);
+       std::tie(next_pos, ok) = next(next_pos)) {
+    const DijkstraNode& node = integration_.at(next_pos);
+    if (node.entity) break;
+    // Distances count the cost of entering each tile from the one after it.
+    const unsigned int cost = node.dist - integration_.at(node.prev).dist;
+    if (spent + cost > budget) break;
+    spent += cost;
+    pos = next_pos;
+  }
+  return pos;
+}
+
+bool step_along_flow(Ecs& ecs, const FlowField& field, EntityId id) {
+  GridPos* gpos = nullptr;
+  if (ecs.read(id, &gpos) != EcsError::OK) return false;
+  auto [next, ok] = field.next(gpos->pos);
+  if (!ok) return false;
+  for (const auto& [other, other_pos, unused_actor] :
+       ecs.read_all<GridPos, Actor>())
+    if (other_pos.pos == next) return false;
+  gpos->pos = next;
+  return true;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+// Flow fields: for every tile, which way to step to get closer to the nearest
+// of a set of goals. Once one is built, any number of units heading the same
+// way can find their next step with a single read instead of each needing a
+// path of their own.
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <glm/vec2.hpp>
+
+#include "dijkstra.h"
+
+class FlowField {
+  // Steps are indices into adjacent_steps(), or one of these.
+  static constexpr std::uint8_t AT_GOAL = 0xfe;
+  static constexpr std::uint8_t NO_WAY = 0xff;
+
+  // How far each tile is from the nearest goal.
+  DijkstraGrid integration_;
+
+  // One step per tile of the grid's bounding box, as of the last generate().
+  glm::ivec2 min_ = {0, 0};
+  glm::ivec2 size_ = {0, 0};
+  std::vector<std::uint8_t> steps_;
+
+  bool in_box(glm::ivec2 p) const {
+    return p.x >= min_.x && p.y >= min_.y &&
+           p.x < min_.x + size_.x && p.y < min_.y + size_.y;
+  }
+  std::size_t index(glm::ivec2 p) const {
+    return std::size_t(p.y - min_.y) * size_.x + (p.x - min_.x);
+  }
+
+  void update_step(glm::ivec2 pos);
+  void update_all(const Grid& grid);
+
+public:
+  explicit FlowField(PathCosts costs = PathCosts::MOVE_COST)
+    : integration_(costs) { }
+
+  // Units in `occupants` block the way, as in DijkstraGrid, so leave them out
+  // for a field that a whole crowd will be sharing.
+  void generate(const Grid& grid, std::span<const glm::ivec2> goals,
+                std::span<const Occupant> occupants = {});
+  void generate(const Game& game, std::span<const glm::ivec2> goals);
+
+  // Catches up on changes like DijkstraGrid::repair() and refresh(), only
+  // touching the steps of tiles whose distance changed.
+  void repair(const Grid& grid, std::span<const Occupant> occupants,
+              std::span<const glm::ivec2> changed);
+  void refresh(const Game& game, std::span<const glm::ivec2> goals);
+
+  // The next tile on the way to the nearest goal. False at a goal or where
+  // none can be reached.
+  std::pair<glm::ivec2, bool> next(glm::ivec2 pos) const {
+    if (!in_box(pos)) return {pos, false};
+    const std::uint8_t step = steps_[index(pos)];
+    if (step >= adjacent_steps().size()) return {pos, false};
+    return {pos + adjacent_steps()[step], true};
+  }
+
+  bool reaches(glm::ivec2 pos) const {
+    return in_box(pos) && steps_[index(pos)] != NO_WAY;
+  }
+  bool at_goal(glm::ivec2 pos) const {
+    return in_box(pos) && steps_[index(pos)] == AT_GOAL;
+  }
+
+  // Follows the field from `pos` as far as a unit there could walk for
+  // `budget`, stopping short of the goal itself and of any unit in the way,
+  // like descend().
+  glm::ivec2 follow(glm::ivec2 pos, unsigned int budget) const;
+
+  const DijkstraGrid& integration() const { return integration_; }
+};
+
+// Moves `id` one step along `field` by writing to its GridPos, which claims
+// the tile for it right away, unless it's at a goal or someone's standing in
+// the way. Returns false if it didn't move. Each step of
+// push_move_along_flow() is one of these.
+bool step_along_flow(Ecs& ecs, const FlowField& field, EntityId id);
@@ -0,0 +1,98 @@
+#include "fov.h"
+
+void VisibilitySet::reset(glm::ivec2 origin, int radius) {
+  origin_ = origin;
+  radius_ = radius;
+  bits_.assign((2 * radius + 1) * (2 * radius + 1), false);
+}
+
+static bool blocks_sight(const Grid& grid, glm::ivec2 pos) {
+  auto [tile, exists] = grid.get(pos);
+  return !exists || tile.opaque;
+}
+
+// Transforms an octant-local (dx, dy) into world space so that one scanning
+// routine covers all eight octants.
+struct Octant { int xx, xy, yx, yy; };
+
+static constexpr Octant OCTANTS[8] = {
+  { 1,  0,  0,  1}, { 0,  1,  1,  0}, { 0, -1,  1,  0}, {-1,  0,  0,  1},
+  {-1,  0,  0, -1}, { 0, -1, -1,  0}, { 0,  1, -1,  0}, { 1,  0,  0, -1},
+};
+
+// Scans the rows of one octant starting at `row`, lighting everything between
+// the `start` and `end` slopes. When a run of opaque tiles starts, the part of
+// the row above it is scanned recursively with a narrower view and this scan
+// continues past the run with what's left.
+//
+// See: http://www.roguebasin.com/index.php/FOV_using_recursive_shadowcasting
+static void cast_light(const Grid& grid, glm::ivec2 origin, int radius,
+                       int row, float start, float end, const Octant& oct,
+                       VisibilitySet& out) {
+  if (start < end) return;
+
+  const int radius_sq = radius * radius + radius;
+  float new_start = 0.f;
+  for (int j = row; j <= radius; ++j) {
+    bool blocked = false;
+    const int dy = -j;
+    for (int dx = -j; dx <= 0; ++dx) {
+      float left_slope = (dx - 0.5f) / (dy + 0.5f);
+      float right_slope = (dx + 0.5f) / (dy - 0.5f);
+      if (start < right_slope) continue;
+      if (end > left_slope) break;
+
+      glm::ivec2 pos = origin + glm::ivec2(dx * oct.xx + dy * oct.xy,
+                                           dx * oct.yx + dy * oct.yy);
+      if (dx * dx + dy * dy <= radius_sq) out.insert(pos);
+
+      bool opaque = blocks_sight(grid, pos);
+      if (blocked) {
+        if (opaque) {
+          new_start = right_slope;
+        } else {
+          blocked = false;
+          start = new_start;
+        }
+      } else if (opaque && j < radius) {
+        blocked = true;
+        cast_light(grid, origin, radius, j + 1, start, left_slope, oct, out);
+        new_start = right_slope;
+      }
+    }
+    if (blocked) break;
+  }
+}
+
+void compute_fov(const Grid& grid, glm::ivec2 origin, int radius,
+                 VisibilitySet& out) {
+  out.reset(origin, radius);
+  out.insert(origin);
+  for (const Octant& oct : OCTANTS)
+    cast_light(grid, origin, radius, 1, 1.f, 0.f, oct, out);
+}
+
+const VisibilitySet& VisionCache::get(const Grid& grid, EntityId id,
+                                      glm::ivec2 pos, int radius) {
+  auto [it, inserted] = entries_.try_emplace(id.id);
+  Entry& entry = it->second;
+
+  bool stale = inserted || entry.visible.origin() != pos ||
+               entry.visible.radius() != radius;
+  if (!stale && entry.grid_version != grid.version()) {
+    for (glm::ivec2 changed : grid.changes_since(entry.grid_version)) {
+      glm::ivec2 d = glm::abs(changed - pos);
+      if (d.x <= radius && d.y <= radius) {
+        stale = true;
+        break;
+      }
+    }
+  }
+
+  if (stale) {
+    compute_fov(grid, pos, radius, entry.visible);
+    ++n_computed_;
+  }
+  entry.grid_version = grid.version();
+  return entry.visible;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+// Field of view. Opaque tiles, and anything off the edge of the grid, block
+// sight.
+
+#include <unordered_map>
+#include <vector>
+
+#include <glm/vec2.hpp>
+
+#include "include/ecs.h"
+#include "grid.h"
+
+// The tiles visible from one position, stored as a bitmap of the square that
+// the sight radius fits in.
+class VisibilitySet {
+  glm::ivec2 origin_ = {0, 0};
+  int radius_ = -1;
+  std::vector<bool> bits_;
+
+  int index(glm::ivec2 pos) const {
+    glm::ivec2 local = pos - origin_ + radius_;
+    return local.y * (2 * radius_ + 1) + local.x;
+  }
+
+public:
+  void reset(glm::ivec2 origin, int radius);
+
+  void insert(glm::ivec2 pos) { bits_[index(pos)] = true; }
+
+  bool contains(glm::ivec2 pos) const {
+    glm::ivec2 d = glm::abs(pos - origin_);
+    return d.x <= radius_ && d.y <= radius_ && bits_[index(pos)];
+  }
+
+  glm::ivec2 origin() const { return origin_; }
+  int radius() const { return radius_; }
+};
+
+// Recursive shadowcasting, one octant at a time. Tiles are visible within a
+// circle of `radius` around `origin`.
+void compute_fov(const Grid& grid, glm::ivec2 origin, int radius,
+                 VisibilitySet& out);
+
+// Remembers what each actor could see so it need only be recomputed when the
+// actor moves or a tile it could see changes.
+class VisionCache {
+  struct Entry {
+    VisibilitySet visible;
+    unsigned int grid_version;
+  };
+
+  std::unordered_map<unsigned int, Entry> entries_;  // Keyed by EntityId::id.
+  unsigned int n_computed_ = 0;
+
+public:
+  const VisibilitySet& get(const Grid& grid, EntityId id, glm::ivec2 pos,
+                           int radius);
+
+  void forget(EntityId id) { entries_.erase(id.id); }
+  void clear() { entries_.clear(); }
+
+  // How many times get() had to actually run compute_fov().
+  unsigned int n_computed() const { return n_computed_; }
+};
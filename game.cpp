@@ -11,14 +11,46 @@ Error Game::init() {
          text_font_map_.init("font/LeagueMono-Regular.ttf");
 }
 
+static GlyphRenderConfig tile_render_config(FontMap& font_map,
+                                            const Tile& tile) {
+  GlyphRenderConfig rc(font_map.get(tile.glyph), tile.fg_color,
+                       tile.bg_color);
+  rc.center();
+  return rc;
+}
+
 void Game::set_grid(Grid grid) {
+  for (const auto& [pos, id] : tile_entities_) ecs().mark_to_delete(id);
+  tile_entities_.clear();
+
   for (auto [pos, tile] : grid) {
-    GlyphRenderConfig rc(font_map_.get(tile.glyph), tile.fg_color,
-                         tile.bg_color);
-    rc.center();
-    ecs().write_new_entity(Transform{pos, Transform::GRID}, std::vector{rc});
+    tile_entities_[pos] = ecs().write_new_entity(
+        Transform{pos, Transform::GRID},
+        std::vector{tile_render_config(font_map_, tile)});
   }
   grid_ = std::move(grid);
+  regions_.build(grid_);
+  hierarchy_.build(grid_);
+  vision_.clear();
+}
+
+void Game::track_occupancy() {
+  // The first unit found on a tile is the one that counts, as in actor_at().
+  std::unordered_map<glm::ivec2, EntityId> now;
+  now.reserve(occupancy_.size());
+  for (const auto& [id, gpos, unused_actor] : ecs().read_all<GridPos, Actor>())
+    now.try_emplace(gpos.pos, id);
+
+  for (const auto& [pos, id] : occupancy_) {
+    auto it = now.find(pos);
+    if (it == now.end() || it->second != id) occupancy_changes_.push_back(pos);
+  }
+  for (const auto& [pos, id] : now)
+    if (!occupancy_.contains(pos)) occupancy_changes_.push_back(pos);
+
+  occupancy_ = std::move(now);
+  threats_.update(*this);
+  unit_buckets_.update(*this);
 }
 
 unsigned int Game::gen_script_vars_and_id() {
@@ -7,11 +7,18 @@
 #include <glm/vec2.hpp>
 
 #include "constants.h"
+#include "astar.h"
+#include "buckets.h"
 #include "components.h"
 #include "decision.h"
 #include "font.h"
+#include "fov.h"
 #include "grid.h"
+#include "hpa.h"
+#include "paths.h"
+#include "regions.h"
 #include "shaders.h"
+#include "threat.h"
 #include "timer.h"
 #include "ui.h"
 
@@ -35,6 +42,7 @@ struct Turn {
 class Game {
   Ecs ecs_;
   Grid grid_;
+  std::unordered_map<glm::ivec2, EntityId> tile_entities_;  // For rendering.
   Turn turn_;  // represents the current entitie's turn.
   Decision decision_;
 
@@ -56,6 +64,26 @@ class Game {
   std::vector<ScriptEngine> independent_scripts_;
   std::list<ScriptEngine> ordered_scripts_;
 
+  // Derived from the grid and entities; not part of the game state.
+  RegionMap regions_;
+  PathHierarchy hierarchy_;
+  mutable VisionCache vision_;
+  mutable AStar path_finder_ = AStar(PathCosts::MOVE_COST);
+
+  // Who stood where as of the last track_occupancy(), and every tile that has
+  // changed hands since the start, like Grid's change log. It's never trimmed,
+  // so readers should only ever ask for the changes since their own version.
+  std::unordered_map<glm::ivec2, EntityId> occupancy_;
+  std::vector<glm::ivec2> occupancy_changes_;
+
+  // Who could hit what next turn and who stands near whom, brought up to date
+  // with track_occupancy().
+  ThreatMap threats_;
+  UnitBuckets unit_buckets_;
+
+  // Paths being walked by scripts.
+  PathPool paths_;
+
   std::map<unsigned int, Vars> script_vars_;
   unsigned int current_script_id_ = 0;
   unsigned int gen_script_vars_and_id();
@@ -66,6 +94,31 @@ public:
 
   void set_grid(Grid grid);
 
+  const RegionMap& regions() const { return regions_; }
+  const PathHierarchy& hierarchy() const { return hierarchy_; }
+  VisionCache& vision() const { return vision_; }
+
+  PathPool& paths() { return paths_; }
+
+  // For one-off paths; see astar.h.
+  AStar& path_finder() const { return path_finder_; }
+
+  // Units move by having their GridPos written to, so nothing sees it happen.
+  // This compares where everyone is against the last call and logs the tiles
+  // that someone left or arrived at.
+  // Also restamps the threat map for any unit that moved and sorts everyone
+  // into unit_buckets().
+  void track_occupancy();
+  unsigned int occupancy_version() const { return occupancy_changes_.size(); }
+  std::span<const glm::ivec2> occupancy_changes_since(
+      unsigned int version) const {
+    return std::span(occupancy_changes_).subspan(
+        std::min<std::size_t>(version, occupancy_changes_.size()));
+  }
+
+  const ThreatMap& threats() const { return threats_; }
+  const UnitBuckets& unit_buckets() const { return unit_buckets_; }
+
   Decision& decision() { return decision_; }
   const Decision& decision() const { return decision_; }
 
@@ -38,13 +38,3 @@ Grid arena_grid(glm::ivec2 dimensions, const Tile& wall, const Tile& floor) {
   }
   return grid;
 }
-
-std::vector<glm::ivec2> adjacent_steps() {
-  return {{1, 0}, {0, 1}, {-1, 0}, {0, -1}};
-}
-
-std::vector<glm::ivec2> adjacent_positions(glm::ivec2 p) {
-  std::vector<glm::ivec2> adj = adjacent_steps();
-  for (glm::ivec2& v : adj) v += p;
-  return adj;
-}
@@ -1,9 +1,13 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <span>
 #include <string_view>
 #include <unordered_map>
 #include <vector>
 
+#include <glm/common.hpp>
 #include <glm/vec2.hpp>
 #include <glm/vec4.hpp>
 
@@ -12,11 +16,19 @@
 
 struct Tile {
   bool walkable = false;
+  bool opaque = false;  // Blocks line of sight.
+  // Movement points it takes to step onto this tile, at least one. Only paths
+  // counting PathCosts::MOVE_COST pay attention to this.
+  unsigned char move_cost = 1;
   char glyph = ' ';
   glm::vec4 fg_color;
   glm::vec4 bg_color;
 };
 
+// What the length of a path counts: steps, or the Tile::move_cost of every
+// tile stepped onto.
+enum class PathCosts { STEPS, MOVE_COST };
+
 struct Grid {
   std::unordered_map<glm::ivec2, Tile> data_;
 
@@ -24,6 +36,16 @@ struct Grid {
   // contain this tile.
   Tile dummy_notreal;
 
+  // Every tile changed through set(), in order. The version of the grid is
+  // just the number of changes so far, so the log is never trimmed: it grows
+  // by one entry per set() for the life of the grid. That's cheap as long as
+  // the map only changes now and then, rather than every turn.
+  std::vector<glm::ivec2> changes_;
+
+  // The smallest box holding every tile, min inclusive and max exclusive.
+  glm::ivec2 min_ = {0, 0};
+  glm::ivec2 max_ = {0, 0};
+
 public:
   bool has(glm::ivec2 pos) { return data_.contains(pos); }
 
@@ -42,8 +64,34 @@ public:
   Tile& at(glm::ivec2 pos) { return get(pos).first; }
   const Tile& at(glm::ivec2 pos) const { return get(pos).first; }
 
+  void reserve(std::size_t n) { data_.reserve(n); }
+
+  // Once a grid is in use, changes should go through here so that anything
+  // caching information about the grid can tell what changed.
+  void set(glm::ivec2 pos, const Tile& tile) {
+    (*this)[pos] = tile;
+    changes_.push_back(pos);
+  }
+
+  unsigned int version() const { return changes_.size(); }
+
+  glm::ivec2 bounds_min() const { return min_; }
+  glm::ivec2 bounds_max() const { return max_; }
+
+  // The tiles changed since the grid was at `version`, oldest first.
+  std::span<const glm::ivec2> changes_since(unsigned int version) const {
+    return std::span(changes_).subspan(std::min<std::size_t>(version,
+                                                             changes_.size()));
+  }
+
   Tile& operator[](glm::ivec2 pos) {
-    return data_.emplace(pos, dummy_notreal).first->second;
+    auto [it, inserted] = data_.emplace(pos, dummy_notreal);
+    if (inserted) {
+      if (data_.size() == 1) min_ = max_ = pos;
+      min_ = glm::min(min_, pos);
+      max_ = glm::max(max_, pos + 1);
+    }
+    return it->second;
   }
 
   auto begin() { return data_.begin(); }
@@ -57,5 +105,41 @@ Grid grid_from_string(std::string_view grid_s,
 
 Grid arena_grid(glm::ivec2 dimensions, const Tile& wall, const Tile& floor);
 
-std::vector<glm::ivec2> adjacent_steps();
-std::vector<glm::ivec2> adjacent_positions(glm::ivec2);
+// The steps from a tile to its neighbours. Units walk along the axes only, but
+// diamond_dist() also counts the diagonals as adjacent.
+inline constexpr std::array<glm::ivec2, 4> ADJACENT_STEPS = {{
+  {1, 0}, {0, 1}, {-1, 0}, {0, -1}
+}};
+
+// A range over the neighbours of a tile, computed as it's iterated so nothing
+// is allocated.
+class Neighbors {
+  glm::ivec2 center_;
+  std::span<const glm::ivec2> steps_;
+
+public:
+  struct iterator {
+    glm::ivec2 center;
+    const glm::ivec2* step;
+
+    glm::ivec2 operator*() const { return center + *step; }
+    iterator& operator++() { ++step; return *this; }
+    bool operator==(const iterator& other) const { return step == other.step; }
+    bool operator!=(const iterator& other) const { return step != other.step; }
+  };
+
+  constexpr Neighbors(glm::ivec2 center, std::span<const glm::ivec2> steps)
+    : center_(center), steps_(steps) { }
+
+  iterator begin() const { return {center_, steps_.data()}; }
+  iterator end() const { return {center_, steps_.data() + steps_.size()}; }
+  std::size_t size() const { return steps_.size(); }
+};
+
+constexpr std::span<const glm::ivec2, 4> adjacent_steps() {
+  return ADJACENT_STEPS;
+}
+
+constexpr Neighbors adjacent_positions(glm::ivec2 p) {
+  return Neighbors(p, ADJACENT_STEPS);
+}
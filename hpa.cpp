@@ -0,0 +1,323 @@
+#include "hpa.h"
+
+#include <algorithm>
+#include <queue>
+#include <set>
+#include <tuple>
+
+#include "math.h"
+
+// Entrances this long or longer get one at each end instead of one in the
+// middle so that paths don't all squeeze through the same tile.
+constexpr int LONG_ENTRANCE = 6;
+
+static bool walkable(const Grid& grid, glm::ivec2 pos) {
+  auto [tile, exists] = grid.get(pos);
+  return exists && tile.walkable;
+}
+
+static int floor_div(int a, int b) {
+  return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+glm::ivec2 PathHierarchy::cluster_of(glm::ivec2 pos) const {
+  return {floor_div(pos.x, cluster_size_), floor_div(pos.y, cluster_size_)};
+}
+
+void PathHierarchy::add_entrances(const Grid& grid, glm::ivec2 cluster,
+                                  glm::ivec2 dir) {
+  const glm::ivec2 along(dir.y, dir.x);
+  const glm::ivec2 first = cluster_min(cluster) + dir * (cluster_size_ - 1);
+  auto open = [&](int i) {
+    glm::ivec2 pos = first + along * i;
+    return walkable(grid, pos) && walkable(grid, pos + dir);
+  };
+
+  auto add_node = [&](glm::ivec2 pos, glm::ivec2 other) {
+    auto [it, inserted] = nodes_.try_emplace(pos);
+    if (inserted) cluster_nodes_[cluster_of(pos)].push_back(pos);
+    it->second.inter.push_back(other);
+  };
+  auto link = [&](int i) {
+    glm::ivec2 pos = first + along * i;
+    add_node(pos, pos + dir);
+    add_node(pos + dir, pos);
+  };
+
+  for (int i = 0; i < cluster_size_; ++i) {
+    if (!open(i)) continue;
+    int j = i;
+    while (j + 1 < cluster_size_ && open(j + 1)) ++j;
+    if (j - i + 1 >= LONG_ENTRANCE) {
+      link(i);
+      link(j);
+    } else {
+      link((i + j) / 2);
+    }
+    i = j;
+  }
+}
+
+void PathHierarchy::remove_entrances(glm::ivec2 cluster, glm::ivec2 dir) {
+  const int axis = dir.x ? 0 : 1;
+  const int last = cluster_min(cluster)[axis] + cluster_size_ - 1;
+
+  // Tiles on the near side link to pos + dir and on the far side, pos - dir.
+  for (glm::ivec2 side : {cluster, cluster + dir}) {
+    auto list = cluster_nodes_.find(side);
+    if (list == cluster_nodes_.end()) continue;
+
+    std::erase_if(list->second, [&](glm::ivec2 pos) {
+      glm::ivec2 across;
+      if (pos[axis] == last) across = pos + dir;
+      else if (pos[axis] == last + 1) across = pos - dir;
+      else return false;
+
+      Node& node = nodes_.at(pos);
+      std::erase(node.inter, across);
+      if (!node.inter.empty()) return false;
+      nodes_.erase(pos);
+      return true;
+    });
+  }
+}
+
+void PathHierarchy::cluster_distances(const Grid& grid, glm::ivec2 cluster,
+                                      glm::ivec2 from,
+                                      const std::vector<glm::ivec2>& targets,
+                                      std::vector<int>& dist) const {
+  const glm::ivec2 min = cluster_min(cluster);
+  const int size = cluster_size_;
+  auto index = [&](glm::ivec2 pos) {
+    return (pos.y - min.y) * size + pos.x - min.x;
+  };
+  auto inside = [&](glm::ivec2 pos) {
+    return pos.x >= min.x && pos.y >= min.y &&
+           pos.x < min.x + size && pos.y < min.y + size;
+  };
+
+  std::vector<int> d(size * size, -1);
+  std::vector<glm::ivec2> queue;
+  queue.reserve(size * size);
+  d[index(from)] = 0;
+  queue.push_back(from);
+  for (std::size_t head = 0; head < queue.size(); ++head) {
+    glm::ivec2 pos = queue[head];
+    for (glm::ivec2 next : adjacent_positions(pos)) {
+      if (!inside(next) || d[index(next)] != -1 || !walkable(grid, next))
+        continue;
+      d[index(next)] = d[index(pos)] + 1;
+      queue.push_back(next);
+    }
+  }
+
+  dist.clear();
+  for (glm::ivec2 target : targets)
+    dist.push_back(inside(target) ? d[index(target)] : -1);
+}
+
+bool PathHierarchy::cluster_path(const Grid& grid, glm::ivec2 from,
+                                 glm::ivec2 to,
+                                 std::vector<glm::ivec2>& out) const {
+  if (from == to) return true;
+
+  const glm::ivec2 min = cluster_min(cluster_of(from));
+  const int size = cluster_size_;
+  auto index = [&](glm::ivec2 pos) {
+    return (pos.y - min.y) * size + pos.x - min.x;
+  };
+  auto inside = [&](glm::ivec2 pos) {
+    return pos.x >= min.x && pos.y >= min.y &&
+           pos.x < min.x + size && pos.y < min.y + size;
+  };
+  if (!inside(to)) return false;
+
+  // Search backwards from `to` so that following prev from `from` walks the
+  // path in order.
+  std::vector<glm::ivec2> prev(size * size);
+  std::vector<bool> seen(size * size, false);
+  std::vector<glm::ivec2> queue;
+  seen[index(to)] = true;
+  queue.push_back(to);
+  for (std::size_t head = 0; head < queue.size() && !seen[index(from)];
+       ++head) {
+    glm::ivec2 pos = queue[head];
+    for (glm::ivec2 next : adjacent_positions(pos)) {
+      if (!inside(next) || seen[index(next)] || !walkable(grid, next))
+        continue;
+      seen[index(next)] = true;
+      prev[index(next)] = pos;
+      queue.push_back(next);
+    }
+  }
+
+  if (!seen[index(from)]) return false;
+  for (glm::ivec2 pos = from; pos != to;) {
+    pos = prev[index(pos)];
+    out.push_back(pos);
+  }
+  return true;
+}
+
+void PathHierarchy::link_cluster(const Grid& grid, glm::ivec2 cluster) {
+  auto it = cluster_nodes_.find(cluster);
+  if (it == cluster_nodes_.end()) return;
+  const std::vector<glm::ivec2>& entrances = it->second;
+
+  std::vector<int> dist;
+  for (glm::ivec2 pos : entrances) {
+    Node& node = nodes_.at(pos);
+    node.intra.clear();
+    cluster_distances(grid, cluster, pos, entrances, dist);
+    for (std::size_t i = 0; i < entrances.size(); ++i)
+      if (dist[i] > 0) node.intra.push_back({entrances[i], unsigned(dist[i])});
+  }
+}
+
+void PathHierarchy::build(const Grid& grid) {
+  nodes_.clear();
+  cluster_nodes_.clear();
+  clusters_.clear();
+
+  for (const auto& [pos, tile] : grid) clusters_.insert(cluster_of(pos));
+  for (glm::ivec2 cluster : clusters_) {
+    add_entrances(grid, cluster, {1, 0});
+    add_entrances(grid, cluster, {0, 1});
+  }
+  for (glm::ivec2 cluster : clusters_) link_cluster(grid, cluster);
+
+  grid_version_ = grid.version();
+}
+
+void PathHierarchy::update(const Grid& grid) {
+  std::span<const glm::ivec2> changes = grid.changes_since(grid_version_);
+  if (changes.empty()) return;
+
+  // Every border of every cluster with a changed tile gets redone, then
+  // every cluster on either side of those borders.
+  std::set<std::tuple<int, int, int, int>> borders;
+  for (glm::ivec2 pos : changes) {
+    glm::ivec2 cluster = cluster_of(pos);
+    clusters_.insert(cluster);
+    for (glm::ivec2 dir : {glm::ivec2(1, 0), glm::ivec2(0, 1)}) {
+      for (glm::ivec2 c : {cluster, cluster - dir})
+        borders.emplace(c.x, c.y, dir.x, dir.y);
+    }
+  }
+
+  for (auto [x, y, dx, dy] : borders) remove_entrances({x, y}, {dx, dy});
+  for (auto [x, y, dx, dy] : borders) add_entrances(grid, {x, y}, {dx, dy});
+
+  std::unordered_set<glm::ivec2> relink;
+  for (auto [x, y, dx, dy] : borders) {
+    relink.insert(glm::ivec2(x, y));
+    relink.insert(glm::ivec2(x + dx, y + dy));
+  }
+  for (glm::ivec2 cluster : relink) link_cluster(grid, cluster);
+
+  grid_version_ = grid.version();
+}
+
+bool PathHierarchy::plan(const Grid& grid, glm::ivec2 start, glm::ivec2 goal,
+                         HierarchicalPath& out) const {
+  out.waypoints.clear();
+  out.tiles.clear();
+  out.next_waypoint = 1;
+  if (!walkable(grid, start) || !walkable(grid, goal)) return false;
+
+  static const std::vector<glm::ivec2> NO_NODES;
+  auto entrances_of = [&](glm::ivec2 cluster) -> const std::vector<glm::ivec2>& {
+    auto it = cluster_nodes_.find(cluster);
+    return it == cluster_nodes_.end() ? NO_NODES : it->second;
+  };
+
+  // Connect the start and goal to the entrances of their own clusters. If
+  // they share a cluster, the start might also get to the goal directly.
+  const glm::ivec2 start_cluster = cluster_of(start);
+  const glm::ivec2 goal_cluster = cluster_of(goal);
+
+  std::vector<glm::ivec2> start_targets = entrances_of(start_cluster);
+  if (start_cluster == goal_cluster) start_targets.push_back(goal);
+  std::vector<int> dist;
+  cluster_distances(grid, start_cluster, start, start_targets, dist);
+  std::vector<Edge> start_edges;
+  for (std::size_t i = 0; i < start_targets.size(); ++i)
+    if (dist[i] >= 0) start_edges.push_back({start_targets[i],
+                                             unsigned(dist[i])});
+
+  const std::vector<glm::ivec2>& goal_entrances = entrances_of(goal_cluster);
+  cluster_distances(grid, goal_cluster, goal, goal_entrances, dist);
+  std::unordered_map<glm::ivec2, unsigned int> to_goal;
+  for (std::size_t i = 0; i < goal_entrances.size(); ++i)
+    if (dist[i] >= 0) to_goal[goal_entrances[i]] = dist[i];
+
+  // A* over the entrances.
+  struct Visit {
+    unsigned int cost;
+    glm::ivec2 prev;
+    bool closed = false;
+  };
+  std::unordered_map<glm::ivec2, Visit> visits;
+
+  using QueueEntry = std::tuple<unsigned int, unsigned int, int, int>;
+  std::priority_queue<QueueEntry, std::vector<QueueEntry>,
+                      std::greater<QueueEntry>> queue;
+  auto relax = [&](glm::ivec2 from, glm::ivec2 to, unsigned int cost) {
+    auto [it, inserted] = visits.try_emplace(to, Visit{cost, from});
+    if (!inserted) {
+      if (it->second.closed || it->second.cost <= cost) return;
+      it->second = Visit{cost, from};
+    }
+    queue.emplace(cost + manh_dist(to, goal), cost, to.x, to.y);
+  };
+
+  visits[start] = Visit{0, start};
+  queue.emplace(manh_dist(start, goal), 0, start.x, start.y);
+  while (!queue.empty()) {
+    auto [unused_f, cost, x, y] = queue.top();
+    queue.pop();
+    glm::ivec2 pos(x, y);
+    Visit& visit = visits.at(pos);
+    if (visit.closed || cost > visit.cost) continue;
+    visit.closed = true;
+    if (pos == goal) break;
+
+    if (pos == start)
+      for (const Edge& e : start_edges) relax(pos, e.to, cost + e.cost);
+
+    auto node = nodes_.find(pos);
+    if (node != nodes_.end()) {
+      for (const Edge& e : node->second.intra) relax(pos, e.to, cost + e.cost);
+      for (glm::ivec2 across : node->second.inter) relax(pos, across, cost + 1);
+    }
+
+    auto goal_edge = to_goal.find(pos);
+    if (goal_edge != to_goal.end())
+      relax(pos, goal, cost + goal_edge->second);
+  }
+
+  auto reached = visits.find(goal);
+  if (reached == visits.end() || !reached->second.closed) return false;
+
+  for (glm::ivec2 pos = goal; pos != start; pos = visits.at(pos).prev)
+    out.waypoints.push_back(pos);
+  out.waypoints.push_back(start);
+  std::reverse(out.waypoints.begin(), out.waypoints.end());
+  out.tiles.push_back(start);
+  return true;
+}
+
+void PathHierarchy::refine(const Grid& grid, HierarchicalPath& path,
+                           std::size_t min_tiles) const {
+  while (!path.fully_refined() && path.tiles.size() < min_tiles) {
+    glm::ivec2 from = path.tiles.back();
+    glm::ivec2 to = path.waypoints[path.next_waypoint++];
+    if (cluster_of(from) != cluster_of(to)) {
+      // Crossing a border is always a single step.
+      path.tiles.push_back(to);
+    } else if (!cluster_path(grid, from, to, path.tiles)) {
+      // The grid changed out from under the plan.
+      path.next_waypoint = path.waypoints.size();
+    }
+  }
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+// Hierarchical path finding (HPA*).
+//
+// The grid is cut into square clusters. Wherever two clusters touch, each run
+// of open tiles along the border gets an entrance: a pair of tiles, one on
+// either side. The distances between the entrances of a cluster are found
+// ahead of time, so a long path becomes a search over the handful of
+// entrances, and turning that into actual tiles can wait until a unit gets
+// close. When tiles change, only the clusters around them are redone.
+//
+// Like RegionMap, this only knows about terrain. Units are someone else's
+// problem.
+
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <glm/vec2.hpp>
+
+#include "grid.h"
+
+struct HierarchicalPath {
+  // The start, the entrances passed through, and the goal.
+  std::vector<glm::ivec2> waypoints;
+
+  // Tile-by-tile from the start, but only as far as refine() has gotten.
+  std::vector<glm::ivec2> tiles;
+
+  // The waypoint that the next call to refine() will walk to.
+  std::size_t next_waypoint = 1;
+
+  bool fully_refined() const { return next_waypoint >= waypoints.size(); }
+};
+
+class PathHierarchy {
+  struct Edge {
+    glm::ivec2 to;
+    unsigned int cost;
+  };
+
+  struct Node {
+    std::vector<Edge> intra;  // To entrances of the same cluster.
+    std::vector<glm::ivec2> inter;  // Across a border, always one step.
+  };
+
+  int cluster_size_;
+  std::unordered_map<glm::ivec2, Node> nodes_;
+  std::unordered_map<glm::ivec2, std::vector<glm::ivec2>> cluster_nodes_;
+  std::unordered_set<glm::ivec2> clusters_;
+
+  unsigned int grid_version_ = 0;
+
+  glm::ivec2 cluster_of(glm::ivec2 pos) const;
+  glm::ivec2 cluster_min(glm::ivec2 cluster) const {
+    return cluster * cluster_size_;
+  }
+
+  // A border is named by the cluster to its left (or below) and the direction
+  // to the other side, either <1, 0> or <0, 1>.
+  void add_entrances(const Grid& grid, glm::ivec2 cluster, glm::ivec2 dir);
+  void remove_entrances(glm::ivec2 cluster, glm::ivec2 dir);
+  void link_cluster(const Grid& grid, glm::ivec2 cluster);
+
+  // Breadth first search confined to one cluster. Fills `dist` with the
+  // distance to each of `targets`, or -1 if unreachable.
+  void cluster_distances(const Grid& grid, glm::ivec2 cluster,
+                         glm::ivec2 from,
+                         const std::vector<glm::ivec2>& targets,
+                         std::vector<int>& dist) const;
+
+  // Appends the tiles after `from` up to and including `to`, which must be in
+  // the same cluster.
+  bool cluster_path(const Grid& grid, glm::ivec2 from, glm::ivec2 to,
+                    std::vector<glm::ivec2>& out) const;
+
+public:
+  explicit PathHierarchy(int cluster_size = 10)
+    : cluster_size_(cluster_size) { }
+
+  void build(const Grid& grid);
+
+  // Redoes the clusters around any tiles changed since build() or the last
+  // update().
+  void update(const Grid& grid);
+
+  // Finds the waypoints of a path from start to goal, leaving the tiles
+  // unrefined. Returns false if there is no path.
+  bool plan(const Grid& grid, glm::ivec2 start, glm::ivec2 goal,
+            HierarchicalPath& out) const;
+
+  // Refines whole legs of the path until it has at least `min_tiles` tiles or
+  // reaches the goal.
+  void refine(const Grid& grid, HierarchicalPath& path,
+              std::size_t min_tiles) const;
+
+  std::size_t n_entrances() const { return nodes_.size(); }
+};
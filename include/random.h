@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <random>
 
 void random_seed();
@@ -12,3 +13,21 @@ inline int random_sign() { return random_bool() ? -1 : 1; }
 inline float random_float(float min, float max, unsigned int precision) {
   return random_int(min * precision, max * precision) / float(precision);
 }
+
+// Unlike the above, these hold no state: the same inputs always produce the
+// same number. Useful when things get generated out of order, like on several
+// threads at once.
+inline std::uint64_t hash_u64(std::uint64_t x) {
+  // The splitmix64 finalizer.
+  x += 0x9e3779b97f4a7c15ull;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+  return x ^ (x >> 31);
+}
+
+inline std::uint64_t hash_coords(std::uint64_t seed, int x, int y,
+                                 std::uint64_t salt = 0) {
+  std::uint64_t h = hash_u64(seed ^ salt);
+  h = hash_u64(h ^ std::uint32_t(x));
+  return hash_u64(h ^ (std::uint64_t(std::uint32_t(y)) << 32));
+}
@@ -0,0 +1,146 @@
+#include "jps.h"
+
+#include <algorithm>
+#include <bit>
+#include <functional>
+
+#include "math.h"
+
+std::pair<glm::ivec2, bool> JumpPointSearch::jump_x(glm::ivec2 from,
+                                                    int dx) const {
+  const BitGrid& walkable = *walkable_;
+  const glm::ivec2 up(0, 1), down(0, -1), behind(-dx, 0);
+
+  // A tile is worth stopping at if there's an opening above or below it that
+  // wasn't there one step back. Each pass looks at the next 64 tiles along.
+  for (glm::ivec2 pos = from + glm::ivec2(dx, 0);; pos.x += 64 * dx) {
+    auto bits = [&](glm::ivec2 p) {
+      return dx > 0 ? walkable.bits_from(p) : walkable.bits_until(p);
+    };
+    const std::uint64_t open = bits(pos);
+    std::uint64_t stops =
+      ((bits(pos + up) & ~bits(pos + up + behind)) |
+       (bits(pos + down) & ~bits(pos + down + behind))) & open;
+
+    const int to_goal = (goal_.x - pos.x) * dx;
+    if (goal_.y == pos.y && to_goal >= 0 && to_goal < 64)
+      stops |= dx > 0 ? std::uint64_t(1) << to_goal
+                      : std::uint64_t(1) << 63 >> to_goal;
+
+    // Counting from the end nearest `from`.
+    auto first = [dx](std::uint64_t b) {
+      return dx > 0 ? std::countr_zero(b) : std::countl_zero(b);
+    };
+    const int wall = first(~open);
+    const int stop = first(stops);
+    if (stop < wall) return {pos + glm::ivec2(stop * dx, 0), true};
+    if (wall < 64) return {from, false};
+  }
+}
+
+std::pair<glm::ivec2, bool> JumpPointSearch::jump_y(glm::ivec2 from,
+                                                    int dy) const {
+  for (glm::ivec2 pos = from + glm::ivec2(0, dy);; pos.y += dy) {
+    if (!walkable_->get(pos)) return {from, false};
+    if (pos == goal_ || jump_x(pos, 1).second || jump_x(pos, -1).second)
+      return {pos, true};
+  }
+}
+
+bool JumpPointSearch::find_path(const BitGrid& walkable, glm::ivec2 start_pos,
+                                glm::ivec2 goal_pos,
+                                std::vector<glm::ivec2>& path) {
+  path.clear();
+  walkable_ = &walkable;
+  goal_ = goal_pos;
+
+  if (walkable.min() != min_ || walkable.size() != size_) {
+    min_ = walkable.min();
+    size_ = walkable.size();
+    const std::size_t area = std::size_t(size_.x) * size_.y;
+    seen_.assign(area, 0);
+    cost_.resize(area);
+    prev_.resize(area);
+    closed_.assign(area, 0);
+    arrived_.resize(area);
+    search_ = 0;
+  }
+  if (++search_ == 0) {
+    std::fill(seen_.begin(), seen_.end(), 0);
+    std::fill(closed_.begin(), closed_.end(), 0);
+    search_ = 1;
+  }
+  open_.clear();
+  n_expanded_ = 0;
+
+  if (!walkable.get(start_pos) || !walkable.get(goal_pos)) return false;
+
+  const unsigned int start = index(start_pos);
+  const unsigned int goal = index(goal_pos);
+  seen_[start] = search_;
+  cost_[start] = 0;
+  prev_[start] = start;
+  arrived_[start] = glm::ivec2(0, 0);
+
+  auto push = [&](unsigned int i, glm::ivec2 pos) {
+    open_.emplace_back(cost_[i] + manh_dist(pos, goal_pos), ~cost_[i], i);
+    std::push_heap(open_.begin(), open_.end(), std::greater<>());
+  };
+  push(start, start_pos);
+
+  while (!open_.empty()) {
+    std::pop_heap(open_.begin(), open_.end(), std::greater<>());
+    const unsigned int i = std::get<2>(open_.back());
+    open_.pop_back();
+    if (closed_[i] == search_) continue;
+    closed_[i] = search_;
+    ++n_expanded_;
+    if (i == goal) break;
+
+    const glm::ivec2 pos = position(i);
+    auto visit = [&](std::pair<glm::ivec2, bool> jump) {
+      if (!jump.second) return;
+      const unsigned int next = index(jump.first);
+      const unsigned int cost = cost_[i] + manh_dist(pos, jump.first);
+      if (closed_[next] == search_ ||
+          (seen_[next] == search_ && cost_[next] <= cost))
+        return;
+      seen_[next] = search_;
+      cost_[next] = cost;
+      prev_[next] = i;
+      arrived_[next] = glm::sign(jump.first - pos);
+      push(next, jump.first);
+    };
+
+    const glm::ivec2 dir = arrived_[i];
+    if (dir.x) {
+      // Keep going, and turn only where a wall alongside just ended.
+      visit(jump_x(pos, dir.x));
+      for (int dy : {1, -1}) {
+        if (walkable.get(pos + glm::ivec2(0, dy)) &&
+            !walkable.get(pos + glm::ivec2(-dir.x, dy)))
+          visit(jump_y(pos, dy));
+      }
+    } else {
+      // Moving up or down (or just starting), everything's fair game except
+      // going back.
+      for (int dy : {1, -1})
+        if (dy != -dir.y) visit(jump_y(pos, dy));
+      visit(jump_x(pos, 1));
+      visit(jump_x(pos, -1));
+    }
+  }
+
+  if (closed_[goal] != search_) return false;
+
+  // Jump points are always in a straight line from the one before.
+  for (unsigned int i = goal; i != start; i = prev_[i]) {
+    const glm::ivec2 to = position(i);
+    const glm::ivec2 from = position(prev_[i]);
+    const glm::ivec2 step = glm::sign(to - from);
+    for (glm::ivec2 p = to; p != from; p -= step) path.push_back(p);
+  }
+  path.push_back(start_pos);
+  std::reverse(path.begin(), path.end());
+  return true;
+}
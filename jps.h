@@ -0,0 +1,64 @@
+#pragma once
+
+// Jump point search: A* that skips over the long runs of open floor where
+// every way of ordering the same steps is as good as any other, so that only
+// tiles where a path might have to turn go on the open list.
+//
+// This version is for 4-connected grids. Canonical paths go up or down first
+// and then sideways, so moving up or down looks both ways at every step, and
+// a sideways run only stops to turn where a wall beside it just ended. The
+// sideways runs are where most of the time goes, so they scan a whole word of
+// a BitGrid at once.
+//
+// Every step costs the same; for move costs, use AStar.
+
+#include <span>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include <glm/vec2.hpp>
+
+#include "bitboard.h"
+
+class JumpPointSearch {
+  // Flat arrays over the BitGrid's box, tagged with search_ like AStar's.
+  glm::ivec2 min_ = {0, 0};
+  glm::ivec2 size_ = {0, 0};
+  std::vector<unsigned int> seen_;
+  std::vector<unsigned int> cost_;
+  std::vector<unsigned int> prev_;
+  std::vector<unsigned int> closed_;
+  std::vector<glm::ivec2> arrived_;  // The direction from prev_, or zero.
+  unsigned int search_ = 0;
+
+  using OpenEntry = std::tuple<unsigned int, unsigned int, unsigned int>;
+  std::vector<OpenEntry> open_;
+
+  std::size_t n_expanded_ = 0;
+
+  // Only valid during find_path().
+  const BitGrid* walkable_ = nullptr;
+  glm::ivec2 goal_;
+
+  unsigned int index(glm::ivec2 p) const {
+    return (p.y - min_.y) * size_.x + (p.x - min_.x);
+  }
+  glm::ivec2 position(unsigned int i) const {
+    return min_ + glm::ivec2(i % size_.x, i / size_.x);
+  }
+
+  // From `from`, runs sideways or up and down until the first tile that
+  // could be a turn on a shortest path to the goal.
+  std::pair<glm::ivec2, bool> jump_x(glm::ivec2 from, int dx) const;
+  std::pair<glm::ivec2, bool> jump_y(glm::ivec2 from, int dy) const;
+
+public:
+  // The same as AStar::find_path(), but on a BitGrid of the tiles that can be
+  // walked on. Units can be left out of it to block the way.
+  bool find_path(const BitGrid& walkable, glm::ivec2 start, glm::ivec2 goal,
+                 std::vector<glm::ivec2>& path);
+
+  // How many jump points the last search took off the open list.
+  std::size_t n_expanded() const { return n_expanded_; }
+};
@@ -8,6 +8,7 @@
 #include <cstdlib>
 #include <deque>
 #include <iostream>
+#include <map>
 #include <memory>
 #include <unordered_set>
 
@@ -20,15 +21,18 @@
 #include FT_FREETYPE_H
 
 #include "ecs.h"
+#include "ai.h"
 #include "components.h"
 #include "decision.h"
 #include "dijkstra.h"
+#include "flow.h"
 #include "font.h"
 #include "game.h"
 #include "glpp.h"
 #include "grid.h"
 #include "graphics.h"
 #include "math.h"
+#include "reach.h"
 #include "script.h"
 #include "shaders.h"
 #include "timer.h"
@@ -155,36 +159,17 @@ public:
 //
 // The goal is that an entity with twice the speed of another shall move
 // roughly twice as often.
-constexpr int ENERGY_REQUIRED = 1000;
 
 EntityId advance_until_next_turn(Ecs& ecs) {
-  struct AgentRef {
-    EntityId id;
-    Actor& actor;
-    int* energy;
-  };
-
-  std::vector<AgentRef> agents;
-  for (auto [id, actor, agent] : ecs.read_all<Actor, Agent>())
-    agents.push_back({id, actor, &agent.energy});
-
-  if (agents.empty()) return EntityId();
-
-  AgentRef* max_agent = nullptr;
-  EntityId max_id;
-  while (!max_agent || *max_agent->energy < ENERGY_REQUIRED) {
-    for (AgentRef& a : agents) {
-      a.actor.expire_statuses();
-      *a.energy += a.actor.stats.speed;
-      if (!max_agent || *a.energy > *max_agent->energy) max_agent = &a;
-    }
+  std::vector<EntityId> ids;
+  std::vector<TurnTaker> agents;
+  for (auto [id, actor, agent] : ecs.read_all<Actor, Agent>()) {
+    ids.push_back(id);
+    agents.push_back({&agent.energy, &actor.stats, &actor});
   }
 
-  if (!max_agent) return EntityId();
-
-  *max_agent->energy -= ENERGY_REQUIRED;
-
-  return max_agent->id;
+  const int next = next_turn(agents, true);
+  return next < 0 ? EntityId() : ids[next];
 }
 
 EntityId spawn_agent(Game& game, std::string name, glm::ivec2 pos, Team team) {
@@ -211,29 +196,7 @@ void make_hammer_guy(Game& game, EntityId guy) {
   game.ecs().write(guy, std::vector{std::move(rc)}, Ecs::CREATE_OR_UPDATE);
 
   Actor& actor = game.ecs().read_or_panic<Actor>(guy);
-
-  Script on_hit;
-  on_hit.push([guy](Game& game) {
-    glm::ivec2 pos = game.ecs().read_or_panic<GridPos>(guy).pos;
-
-    EntityId defender = game.decision().target;
-    glm::ivec2 defender_pos =
-        game.ecs().read_or_panic<GridPos>(defender).pos;
-
-    glm::ivec2 target_tile = defender_pos + (defender_pos - pos);
-    
-    auto [tile, exists] = game.grid().get(target_tile);
-    if (exists && tile.walkable) {
-      Script script;
-      push_move_along_path(script, defender, {defender_pos, target_tile});
-      game.add_ordered_script(std::move(script));
-    }
-
-    return ScriptResult::CONTINUE;
-  });
-
-  actor.triggers.set("on_hit_enemy", std::move(on_hit));
-      
+  actor.knockback = true;
   game.ecs().write(guy, actor);
 }
 
@@ -500,9 +463,12 @@ Error run() {
   Tile floor{.walkable = true, .glyph = '.',
              .fg_color = glm::vec4(.23f, .23f, .23f, 1.f),
              .bg_color = glm::vec4(.2f, .2f, .2f, 1.f)};
-  Tile wall{.walkable = false, .glyph = '#',
+  Tile wall{.walkable = false, .opaque = true, .glyph = '#',
             .fg_color = glm::vec4(.3f, .3f, .3f, 1.f),
             .bg_color = glm::vec4(.1f, .1f, .1f, 1.f)};
+  Tile mud{.walkable = true, .move_cost = 2, .glyph = '~',
+           .fg_color = glm::vec4(.3f, .25f, .15f, 1.f),
+           .bg_color = glm::vec4(.2f, .17f, .1f, 1.f)};
 
   // Create the tiles.
   //
@@ -512,7 +478,10 @@ Error run() {
   // Also note that the grid represents actual tile data so we don't have to
   // search the ECS every time we want to check a tile. The entities themselves
   // are just used for rendering.
-  game.set_grid(arena_grid({24, 24}, wall, floor));
+  Grid arena = arena_grid({24, 24}, wall, floor);
+  for (int x = 14; x < 18; ++x)
+    for (int y = 4; y < 8; ++y) arena[{x, y}] = mud;
+  game.set_grid(std::move(arena));
 
   make_human(game, spawn_agent(game, "Joe", {3, 3}, Team::PLAYER));
   make_hammer_guy(game, spawn_agent(game, "Jor", {5, 3}, Team::PLAYER));
@@ -524,7 +493,17 @@ Error run() {
 
 
   EntityId whose_turn;
-  DijkstraGrid dijkstra;
+  // Where the current actor can move, from a cache of recent ones.
+  FieldCache move_fields(PathCosts::MOVE_COST, 16 << 20);
+  const DijkstraGrid* dijkstra = nullptr;
+  // Everyone else's, worked out in the background during each turn.
+  FieldPrefetch prefetch(PathCosts::MOVE_COST);
+  // For each team, the way to its nearest enemy. Every CPU actor on a team
+  // shares one, repaired as they take their turns.
+  std::map<Team, FlowField> enemy_flows;
+  // Makes the CPU's decisions while frames keep being drawn, giving each one
+  // 200 ms of tree search.
+  AiWorker ai(std::chrono::milliseconds(200), AiWorker::MONTE_CARLO);
 
   EntityPool movement_indicators;
 
@@ -569,16 +548,36 @@ Error run() {
       game.set_camera_target(
           game.ecs().read_or_panic<Transform>(whose_turn).pos);
 
-      // Find this entity's walkable tiles.
-      const GridPos& grid_pos = game.ecs().read_or_panic<GridPos>(whose_turn);
-      dijkstra.generate(game, grid_pos.pos);
-
       auto move_range =
         game.ecs().read_or_panic<Actor>(whose_turn).stats.move;
 
+      // Find this entity's walkable tiles. The AI also wants to know which
+      // way the nearest enemy is.
+      const GridPos& grid_pos = game.ecs().read_or_panic<GridPos>(whose_turn);
+      const Team team = game.ecs().read_or_panic<Agent>(whose_turn).team;
+      // Anything the last actor was still thinking about is moot now.
+      ai.cancel();
+      game.track_occupancy();
+      // Usually this was prefetched during the last turn, and only needs
+      // catching up on how that turn's actor moved.
+      prefetch.hand_over(move_fields);
+      dijkstra = &move_fields.get(game, grid_pos.pos, move_range);
+      if (team == Team::CPU) {
+        enemy_flows.try_emplace(team, PathCosts::MOVE_COST)
+          .first->second.refresh(game, enemy_positions(game, team));
+      }
+
+      // The next actor could be anyone. Nothing changes the grid during a
+      // turn, so the workers can read it while this one plays out.
+      std::vector<FieldPrefetch::Request> upcoming;
+      for (const auto& [id, gpos, actor] :
+           game.ecs().read_all<GridPos, Actor>())
+        if (id != whose_turn) upcoming.push_back({gpos.pos, actor.stats.move});
+      prefetch.start(game, upcoming);
+
       movement_indicators.deactivate_pool(game.ecs());
       // Add markers that show to where this entity can move.
-      for (const auto& [pos, node] : dijkstra) {
+      for (const auto& [pos, node] : *dijkstra) {
         if (!node.dist || node.dist > move_range) continue;
 
         Marker marker(node.dist ? glm::vec4(0.1f, 0.2f, 0.4f, 0.5f)
@@ -587,6 +586,20 @@ Error run() {
                                        Transform{pos, Transform::OVERLAY},
                                        marker);
       }
+
+      // And where it could attack once it gets there.
+      const Stats& stats = game.ecs().read_or_panic<Actor>(whose_turn).stats;
+      attack_reach(*dijkstra, move_range, stats.range).for_each_set(
+          [&](glm::ivec2 pos) {
+            auto [tile, exists] = game.grid().get(pos);
+            if (!exists || !tile.walkable) return;
+            if (dijkstra->contains(pos) &&
+                dijkstra->at(pos).dist <= move_range)
+              return;
+            movement_indicators.create_new(
+                game.ecs(), Transform{pos, Transform::OVERLAY},
+                Marker(glm::vec4(0.5f, 0.1f, 0.1f, 0.4f)));
+          });
     }
 
     if (game.turn().did_move) {
@@ -610,8 +623,13 @@ Error run() {
       const Agent& whose_turn_agent =
         game.ecs().read_or_panic<Agent>(whose_turn);
 
+      // The decision stays DECIDING until the CPU's made up its mind, which
+      // may take a few frames.
       if (whose_turn_agent.team == Team::CPU) {
-        cpu_decision(game, dijkstra, whose_turn);
+        if (!ai.poll(game.decision()) && ai.idle()) {
+          ai.start(take_snapshot(game, *dijkstra, enemy_flows.at(Team::CPU)),
+                   whose_turn);
+        }
       } else if (whose_turn_agent.team == Team::PLAYER) {
         player_decision(game, whose_turn, input);
       }
@@ -621,12 +639,18 @@ Error run() {
       // We're already acting on the previous decision or script.
     } else if (game.decision().type == Decision::PASS) {
       game.turn().did_pass = true;
+    } else if (game.decision().type == Decision::MOVE_TO &&
+               !dijkstra->contains(game.decision().move_to)) {
+      // Close enough as the crow flies, but too far over rough terrain or
+      // around other units.
+      game.decision().type = Decision::DECIDING;
     } else if (game.decision().type == Decision::MOVE_TO) {
       game.set_camera_target(game.decision().move_to);
 
       Script script;
-      push_move_along_path(script, whose_turn,
-                           path_to(dijkstra, game.decision().move_to));
+      PathHandle path = game.paths().acquire();
+      path_to(*dijkstra, game.decision().move_to, game.paths().get(path));
+      push_move_along_path(script, whose_turn, path);
       game.add_ordered_script(std::move(script));
       game.turn().did_move = true;
       game.decision().type = Decision::DECIDING;
@@ -668,8 +692,12 @@ Error run() {
     }
     game.execute_independent_scripts();
 
-    for (const auto& [id, actor] : game.ecs().read_all<Actor>())
-      if (actor.hp == 0) game.ecs().mark_to_delete(id);
+    for (const auto& [id, actor] : game.ecs().read_all<Actor>()) {
+      if (actor.hp == 0) {
+        game.ecs().mark_to_delete(id);
+        game.vision().forget(id);
+      }
+    }
     game.ecs().deleted_marked_ids();
 
     gl::clear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -0,0 +1,201 @@
+#include "mapgen.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+#include "random.h"
+
+// Salts keep the hashes for different decisions about the same chunk from
+// being correlated.
+enum : std::uint64_t {
+  ROOM_SALT = 1,
+  EAST_DOOR_SALT,
+  NORTH_DOOR_SALT,
+  CAVE_NOISE_SALT,
+};
+
+static void carve(MapChunk& chunk, glm::ivec2 from, glm::ivec2 to) {
+  glm::ivec2 lo = glm::min(from, to);
+  glm::ivec2 hi = glm::max(from, to);
+  for (int y = lo.y; y <= hi.y; ++y)
+    for (int x = lo.x; x <= hi.x; ++x) chunk.at({x, y}) = MAP_FLOOR;
+}
+
+// Where along an edge of length `len` a door goes. Never on a corner so that
+// chunks on the border of the map keep their outer walls.
+static int door_offset(std::uint64_t h, int len) {
+  return len > 2 ? 1 + h % (len - 2) : len / 2;
+}
+
+static void fill_rooms_chunk(const MapGenParams& params, glm::ivec2 chunk_pos,
+                             glm::ivec2 n_chunks, MapChunk& chunk) {
+  std::fill(chunk.cells.begin(), chunk.cells.end(), MAP_WALL);
+
+  // The room keeps at least one wall between itself and the edge of the chunk
+  // so that only corridors join neighbouring rooms.
+  glm::ivec2 center = chunk.size / 2;
+  if (chunk.size.x >= 5 && chunk.size.y >= 5) {
+    std::uint64_t h = hash_coords(params.seed, chunk_pos.x, chunk_pos.y,
+                                  ROOM_SALT);
+    glm::ivec2 room_size, room_pos;
+    for (int axis = 0; axis < 2; ++axis) {
+      int max_len = chunk.size[axis] - 2;
+      int min_len = std::min(3, max_len);
+      room_size[axis] = min_len + (h = hash_u64(h)) % (max_len - min_len + 1);
+      room_pos[axis] = 1 + (h = hash_u64(h)) % (max_len - room_size[axis] + 1);
+    }
+    carve(chunk, room_pos, room_pos + room_size - 1);
+    center = room_pos + room_size / 2;
+  }
+
+  // Each chunk owns the doors on its east and north edges; the west and south
+  // doors belong to the neighbours, but since they're just hashes, we can ask
+  // for them all the same. Corridors always leave the room perpendicular to
+  // the edge so that both halves meet at the door.
+  const glm::ivec2 last = chunk.size - 1;
+  if (chunk_pos.x + 1 < n_chunks.x) {
+    int y = door_offset(hash_coords(params.seed, chunk_pos.x, chunk_pos.y,
+                                    EAST_DOOR_SALT), chunk.size.y);
+    carve(chunk, center, {center.x, y});
+    carve(chunk, {center.x, y}, {last.x, y});
+  }
+  if (chunk_pos.x > 0) {
+    int y = door_offset(hash_coords(params.seed, chunk_pos.x - 1, chunk_pos.y,
+                                    EAST_DOOR_SALT), chunk.size.y);
+    carve(chunk, center, {center.x, y});
+    carve(chunk, {0, y}, {center.x, y});
+  }
+  if (chunk_pos.y + 1 < n_chunks.y) {
+    int x = door_offset(hash_coords(params.seed, chunk_pos.x, chunk_pos.y,
+                                    NORTH_DOOR_SALT), chunk.size.x);
+    carve(chunk, center, {x, center.y});
+    carve(chunk, {x, center.y}, {x, last.y});
+  }
+  if (chunk_pos.y > 0) {
+    int x = door_offset(hash_coords(params.seed, chunk_pos.x, chunk_pos.y - 1,
+                                    NORTH_DOOR_SALT), chunk.size.x);
+    carve(chunk, center, {x, center.y});
+    carve(chunk, {x, 0}, {x, center.y});
+  }
+}
+
+static void fill_caves_chunk(const MapGenParams& params, MapChunk& chunk) {
+  // Each smoothing pass reads one cell past what it writes, so start with an
+  // apron as wide as the number of passes around the chunk. After the last
+  // pass, the cells inside the chunk come out exactly as they would had the
+  // whole map been smoothed at once.
+  const int apron = std::max(0, params.cave_iterations);
+  const glm::ivec2 origin = chunk.origin - apron;
+  const glm::ivec2 size = chunk.size + 2 * apron;
+
+  auto on_border = [&](glm::ivec2 world) {
+    return world.x <= 0 || world.y <= 0 ||
+           world.x >= params.dimensions.x - 1 ||
+           world.y >= params.dimensions.y - 1;
+  };
+
+  std::vector<std::uint8_t> walls(size.x * size.y);
+  for (int y = 0; y < size.y; ++y) {
+    for (int x = 0; x < size.x; ++x) {
+      glm::ivec2 world = origin + glm::ivec2(x, y);
+      walls[y * size.x + x] =
+        on_border(world) ||
+        hash_coords(params.seed, world.x, world.y, CAVE_NOISE_SALT) % 100 <
+          std::uint64_t(params.cave_fill_percent);
+    }
+  }
+
+  // The usual 4-5 rule: a cell becomes a wall if five or more of the nine
+  // cells around and including it are walls.
+  std::vector<std::uint8_t> next = walls;
+  for (int i = 0; i < apron; ++i) {
+    for (int y = 1; y < size.y - 1; ++y) {
+      for (int x = 1; x < size.x - 1; ++x) {
+        int n = 0;
+        for (int dy = -1; dy <= 1; ++dy)
+          for (int dx = -1; dx <= 1; ++dx)
+            n += walls[(y + dy) * size.x + x + dx];
+        next[y * size.x + x] =
+          n >= 5 || on_border(origin + glm::ivec2(x, y));
+      }
+    }
+    std::swap(walls, next);
+  }
+
+  for (int y = 0; y < chunk.size.y; ++y)
+    for (int x = 0; x < chunk.size.x; ++x)
+      chunk.at({x, y}) = walls[(y + apron) * size.x + x + apron] ? MAP_WALL
+                                                                 : MAP_FLOOR;
+}
+
+std::vector<MapChunk> generate_map_chunks(const MapGenParams& params) {
+  std::vector<MapChunk> chunks;
+  if (params.dimensions.x <= 0 || params.dimensions.y <= 0) return chunks;
+
+  // The last row and column of chunks absorb whatever doesn't divide evenly
+  // rather than being left as slivers too thin to hold a room.
+  const int chunk_size = std::max(1, params.chunk_size);
+  const glm::ivec2 n_chunks = glm::max(params.dimensions / chunk_size,
+                                       glm::ivec2(1));
+  chunks.reserve(n_chunks.x * n_chunks.y);
+  for (int y = 0; y < n_chunks.y; ++y) {
+    for (int x = 0; x < n_chunks.x; ++x) {
+      MapChunk& chunk = chunks.emplace_back();
+      chunk.origin = glm::ivec2(x, y) * chunk_size;
+      chunk.size = glm::ivec2(chunk_size);
+      if (x == n_chunks.x - 1)
+        chunk.size.x = params.dimensions.x - chunk.origin.x;
+      if (y == n_chunks.y - 1)
+        chunk.size.y = params.dimensions.y - chunk.origin.y;
+      chunk.cells.resize(chunk.size.x * chunk.size.y);
+    }
+  }
+
+  auto fill = [&](std::size_t i) {
+    if (params.style == MapGenParams::CAVES) {
+      fill_caves_chunk(params, chunks[i]);
+    } else {
+      glm::ivec2 chunk_pos(i % n_chunks.x, i / n_chunks.x);
+      fill_rooms_chunk(params, chunk_pos, n_chunks, chunks[i]);
+    }
+  };
+
+  // Chunks are handed out one at a time so a slow chunk doesn't hold up the
+  // others, but each writes only to its own slot.
+  std::atomic<std::size_t> next_chunk = 0;
+  auto worker = [&] {
+    for (std::size_t i; (i = next_chunk++) < chunks.size();) fill(i);
+  };
+
+  unsigned int n_threads = params.n_threads;
+  if (!n_threads)
+    n_threads = std::max(1u, std::thread::hardware_concurrency());
+  n_threads = std::min<std::size_t>(n_threads, chunks.size());
+
+  std::vector<std::thread> threads;
+  for (unsigned int i = 1; i < n_threads; ++i) threads.emplace_back(worker);
+  worker();
+  for (std::thread& t : threads) t.join();
+
+  return chunks;
+}
+
+Grid grid_from_chunks(const std::vector<MapChunk>& chunks,
+                      const std::unordered_map<char, Tile>& tile_types) {
+  std::size_t n_cells = 0;
+  for (const MapChunk& chunk : chunks) n_cells += chunk.cells.size();
+
+  Grid grid;
+  grid.reserve(n_cells);
+  for (const MapChunk& chunk : chunks) {
+    for (int y = 0; y < chunk.size.y; ++y) {
+      for (int x = 0; x < chunk.size.x; ++x) {
+        auto it = tile_types.find(chunk.at({x, y}));
+        if (it != tile_types.end())
+          grid[chunk.origin + glm::ivec2(x, y)] = it->second;
+      }
+    }
+  }
+  return grid;
+}
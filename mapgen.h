@@ -0,0 +1,64 @@
+#pragma once
+
+// Procedural map generation for large maps and stress scenarios.
+//
+// Maps are built out of dense chunks which never read each other's cells, so
+// any number of threads may fill them in any order. Chunks are chunk_size
+// squares except along the far edges of the map, where they absorb the
+// remainder. Every random choice is a hash of the seed and the world position
+// (or chunk edge) it affects rather than a draw from a shared generator, which
+// is what keeps the same seed producing the same map regardless of the thread
+// count.
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/vec2.hpp>
+
+#include "grid.h"
+
+// Generated maps are described with the same characters grid_from_string()
+// uses so the caller decides what a wall and a floor actually look like.
+constexpr char MAP_WALL = '#';
+constexpr char MAP_FLOOR = '.';
+
+struct MapChunk {
+  glm::ivec2 origin;  // The world position of cells[0].
+  glm::ivec2 size;
+  std::vector<char> cells;  // Row-major: cells[y * size.x + x].
+
+  char& at(glm::ivec2 local) { return cells[local.y * size.x + local.x]; }
+  char at(glm::ivec2 local) const { return cells[local.y * size.x + local.x]; }
+};
+
+struct MapGenParams {
+  enum Style {
+    ROOMS,  // One room per chunk joined to its neighbours by corridors.
+    CAVES,  // Cellular automata smoothed noise.
+  } style = ROOMS;
+
+  glm::ivec2 dimensions = {64, 64};
+  std::uint64_t seed = 0;
+  int chunk_size = 32;
+
+  // Zero means one thread per core.
+  unsigned int n_threads = 0;
+
+  // Only used by CAVES.
+  int cave_fill_percent = 45;
+  int cave_iterations = 4;
+};
+
+// Fills every chunk of the map. The result is ordered by chunk row, then
+// column, and does not depend on n_threads.
+std::vector<MapChunk> generate_map_chunks(const MapGenParams& params);
+
+// Converts the chunks into a Grid, the same way grid_from_string() would.
+Grid grid_from_chunks(const std::vector<MapChunk>& chunks,
+                      const std::unordered_map<char, Tile>& tile_types);
+
+inline Grid generate_grid(const MapGenParams& params,
+                          const std::unordered_map<char, Tile>& tile_types) {
+  return grid_from_chunks(generate_map_chunks(params), tile_types);
+}
@@ -0,0 +1,26 @@
+#include "paths.h"
+
+PathHandle PathPool::acquire() {
+  unsigned int index;
+  if (free_.empty()) {
+    index = slots_.size();
+    slots_.emplace_back();
+  } else {
+    index = free_.back();
+    free_.pop_back();
+  }
+
+  Slot& slot = slots_[index];
+  slot.in_use = true;
+  slot.path.clear();
+  return {index, slot.generation};
+}
+
+void PathPool::release(PathHandle handle) {
+  if (!valid(handle)) return;
+  Slot& slot = slots_[handle.index];
+  slot.in_use = false;
+  // Skip zero, which no handle from acquire() uses.
+  if (++slot.generation == 0) slot.generation = 1;
+  free_.push_back(handle.index);
+}
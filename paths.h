@@ -0,0 +1,59 @@
+#pragma once
+
+// A store of paths that get reused. Scripts that walk a unit somewhere used to
+// each own a vector of their path, allocated when it was found and freed when
+// the walk ended. Here, a finished path's slot goes back on a free list with
+// its memory intact, so once enough paths have been handed out, new ones are
+// written over old ones instead of allocating.
+
+#include <deque>
+#include <vector>
+
+#include <glm/vec2.hpp>
+
+// Names a path in a PathPool. Stays valid until released, however many other
+// paths come and go; after that, the pool knows it's stale.
+struct PathHandle {
+  unsigned int index = 0;
+  unsigned int generation = 0;  // Zero for a handle to nothing.
+
+  explicit operator bool() const { return generation != 0; }
+};
+
+class PathPool {
+  struct Slot {
+    std::vector<glm::vec2> path;
+    unsigned int generation = 1;
+    bool in_use = false;
+  };
+
+  // A deque so that slots don't move when more are added.
+  std::deque<Slot> slots_;
+  std::vector<unsigned int> free_;
+
+public:
+  // An empty path, with whatever room its slot had from last time.
+  PathHandle acquire();
+
+  // Frees the path for reuse. Stale handles are ignored.
+  void release(PathHandle handle);
+
+  // False for handles that were released or never acquired.
+  bool valid(PathHandle handle) const {
+    return handle && handle.index < slots_.size() &&
+           slots_[handle.index].in_use &&
+           slots_[handle.index].generation == handle.generation;
+  }
+
+  // The path itself. Only call with a valid() handle.
+  std::vector<glm::vec2>& get(PathHandle handle) {
+    return slots_[handle.index].path;
+  }
+  const std::vector<glm::vec2>& get(PathHandle handle) const {
+    return slots_[handle.index].path;
+  }
+
+  // How many paths are in use, and how many slots there are altogether.
+  std::size_t size() const { return slots_.size() - free_.size(); }
+  std::size_t capacity() const { return slots_.size(); }
+};
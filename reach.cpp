@@ -0,0 +1,81 @@
+#include "reach.h"
+
+#include <algorithm>
+
+BitGrid dilate(const BitGrid& bits, unsigned int range) {
+  const int r = range;
+  BitGrid out(bits.min() - glm::ivec2(r, r),
+              bits.size() + glm::ivec2(r, r) * 2);
+  if (out.size().x <= 0 || out.size().y <= 0) return out;
+  const int words = out.words_per_row();
+
+  // Copy each row over, shifted r bits along to make room on the left.
+  for (int y = 0; y < bits.size().y; ++y) {
+    std::uint64_t* to = out.row(y + r);
+    for (int i = 0; i < words; ++i)
+      to[i] = bits.bits_from(bits.min() + glm::ivec2(i * 64 - r, y));
+  }
+
+  // Across, one tile at a time, carrying bits between words.
+  for (int y = r; y < r + bits.size().y; ++y) {
+    std::uint64_t* row = out.row(y);
+    for (int step = 0; step < r; ++step) {
+      std::uint64_t carry_left = 0;  // The top bit of the word to the left.
+      for (int i = 0; i < words; ++i) {
+        const std::uint64_t w = row[i];
+        const std::uint64_t next = i + 1 < words ? row[i + 1] : 0;
+        row[i] = w | w << 1 | carry_left >> 63 | w >> 1 | next << 63;
+        carry_left = w;
+      }
+    }
+  }
+
+  // And then up and down, a whole row of words at a time. Each row ORs in the
+  // rows of the input r above and below, so it's done on a copy.
+  std::vector<std::uint64_t> across(std::size_t(words) * out.size().y);
+  for (int y = 0; y < out.size().y; ++y)
+    std::copy_n(out.row(y), words, &across[std::size_t(y) * words]);
+  for (int y = 0; y < out.size().y; ++y) {
+    std::uint64_t* row = out.row(y);
+    const int first = std::max(y - r, 0);
+    const int last = std::min(y + r, out.size().y - 1);
+    for (int from = first; from <= last; ++from) {
+      if (from == y) continue;
+      const std::uint64_t* src = &across[std::size_t(from) * words];
+      for (int i = 0; i < words; ++i) row[i] |= src[i];
+    }
+  }
+
+  // Anything spread past the right edge of the last word isn't in the box.
+  if (out.size().x % 64) {
+    const std::uint64_t mask = (std::uint64_t(1) << out.size().x % 64) - 1;
+    for (int y = 0; y < out.size().y; ++y) out.row(y)[words - 1] &= mask;
+  }
+  return out;
+}
+
+BitGrid standable_bits(const DijkstraGrid& moves, unsigned int move) {
+  auto standable = [&](const DijkstraNode& node) {
+    return node.dist <= move && (node.dist == 0 || !node.entity);
+  };
+
+  glm::ivec2 min(0, 0), max(0, 0);
+  bool any = false;
+  for (const auto& [pos, node] : moves) {
+    if (!standable(node)) continue;
+    min = any ? glm::min(min, pos) : pos;
+    max = any ? glm::max(max, pos) : pos;
+    any = true;
+  }
+  if (!any) return BitGrid();
+
+  BitGrid bits(min, max - min + glm::ivec2(1, 1));
+  for (const auto& [pos, node] : moves)
+    if (standable(node)) bits.set(pos, true);
+  return bits;
+}
+
+BitGrid attack_reach(const DijkstraGrid& moves, unsigned int move,
+                     unsigned int range) {
+  return dilate(standable_bits(moves, move), range);
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+// What an actor could attack this turn: every tile within attack range of a
+// tile it can move to. Rather than checking each pair of tiles, the tiles it
+// can stand on are packed into a BitGrid and grown by the attack range a row
+// of 64 tiles at a time.
+
+#include "bitboard.h"
+#include "dijkstra.h"
+
+// Grows every set bit into the square of tiles within `range` of it, as
+// counted by diamond_dist(). The box grows by `range` on every side so that
+// nothing falls off the edge.
+BitGrid dilate(const BitGrid& bits, unsigned int range);
+
+// The tiles in `moves` within `move` of the source that a unit could end its
+// move on, meaning nobody else stands there.
+BitGrid standable_bits(const DijkstraGrid& moves, unsigned int move);
+
+// Every tile an attack with `range` could hit after moving up to `move`.
+// This doesn't check line of sight, which can_attack() still wants.
+BitGrid attack_reach(const DijkstraGrid& moves, unsigned int move,
+                     unsigned int range);
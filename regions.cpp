@@ -0,0 +1,121 @@
+#include "regions.h"
+
+unsigned int RegionMap::add(glm::ivec2 pos) {
+  auto [it, inserted] = index_.try_emplace(pos, parent_.size());
+  if (inserted) {
+    parent_.push_back(it->second);
+    size_.push_back(1);
+    stamp_.push_back(0);
+  }
+  return it->second;
+}
+
+unsigned int RegionMap::find(unsigned int i) {
+  // Path halving: point every other node on the way up at its grandparent.
+  while (parent_[i] != i) {
+    parent_[i] = parent_[parent_[i]];
+    i = parent_[i];
+  }
+  return i;
+}
+
+void RegionMap::unite(unsigned int a, unsigned int b) {
+  a = find(a);
+  b = find(b);
+  if (a == b) return;
+  if (size_[a] < size_[b]) std::swap(a, b);
+  parent_[b] = a;
+  size_[a] += size_[b];
+}
+
+void RegionMap::relabel_from(glm::ivec2 start) {
+  const unsigned int root = index_.at(start);
+  parent_[root] = root;
+  size_[root] = 0;
+  stamp_[root] = epoch_;
+
+  flood_.clear();
+  flood_.push_back(start);
+  while (!flood_.empty()) {
+    glm::ivec2 pos = flood_.back();
+    flood_.pop_back();
+    ++size_[root];
+
+    for (glm::ivec2 next : adjacent_positions(pos)) {
+      auto it = index_.find(next);
+      if (it == index_.end() || stamp_[it->second] == epoch_) continue;
+      parent_[it->second] = root;
+      stamp_[it->second] = epoch_;
+      flood_.push_back(next);
+    }
+  }
+}
+
+void RegionMap::build(const Grid& grid) {
+  index_.clear();
+  parent_.clear();
+  size_.clear();
+  stamp_.clear();
+
+  index_.reserve(grid.data_.size());
+  for (const auto& [pos, tile] : grid)
+    if (tile.walkable) add(pos);
+
+  // Looking right and up is enough to see every edge once.
+  for (const auto& [pos, i] : index_) {
+    for (glm::ivec2 step : {glm::ivec2(1, 0), glm::ivec2(0, 1)}) {
+      auto it = index_.find(pos + step);
+      if (it != index_.end()) unite(i, it->second);
+    }
+  }
+
+  // Flatten so that region() is a single lookup until the next update.
+  for (unsigned int i = 0; i < parent_.size(); ++i) find(i);
+  for (unsigned int i = 0; i < parent_.size(); ++i) parent_[i] = find(i);
+
+  grid_version_ = grid.version();
+}
+
+void RegionMap::update(const Grid& grid) {
+  std::vector<glm::ivec2> removed;
+  for (glm::ivec2 pos : grid.changes_since(grid_version_)) {
+    auto [tile, exists] = grid.get(pos);
+    bool walkable = exists && tile.walkable;
+    auto it = index_.find(pos);
+
+    if (walkable && it == index_.end()) {
+      unsigned int i = add(pos);
+      for (glm::ivec2 next : adjacent_positions(pos)) {
+        auto adj = index_.find(next);
+        if (adj != index_.end()) unite(i, adj->second);
+      }
+    } else if (!walkable && it != index_.end()) {
+      // The slot is abandoned rather than reused. Anything still pointing at
+      // it gets relabeled below.
+      index_.erase(it);
+      removed.push_back(pos);
+    }
+  }
+
+  // Any tile whose region might have been split off is connected to a
+  // neighbour of a removed tile, so flooding from each of those neighbours
+  // that hasn't been reached yet relabels every piece.
+  ++epoch_;
+  for (glm::ivec2 pos : removed) {
+    for (glm::ivec2 next : adjacent_positions(pos)) {
+      auto it = index_.find(next);
+      if (it != index_.end() && stamp_[it->second] != epoch_)
+        relabel_from(next);
+    }
+  }
+
+  grid_version_ = grid.version();
+}
+
+unsigned int RegionMap::region(glm::ivec2 pos) const {
+  auto it = index_.find(pos);
+  if (it == index_.end()) return NO_REGION;
+  unsigned int i = it->second;
+  while (parent_[i] != i) i = parent_[i];
+  return i;
+}
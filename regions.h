@@ -0,0 +1,56 @@
+#pragma once
+
+// Labels each connected group of walkable tiles so that whether one tile could
+// ever reach another is a comparison instead of a flood fill. Units are
+// ignored since they move; two tiles in the same region may still be cut off
+// from each other by a crowd.
+
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/vec2.hpp>
+
+#include "grid.h"
+
+class RegionMap {
+  // A union-find (disjoint set forest) over the walkable tiles.
+  std::unordered_map<glm::ivec2, unsigned int> index_;
+  std::vector<unsigned int> parent_;
+  std::vector<unsigned int> size_;
+
+  // Marks which tiles update() has already relabeled.
+  std::vector<unsigned int> stamp_;
+  unsigned int epoch_ = 0;
+  std::vector<glm::ivec2> flood_;  // Scratch space for relabel_from().
+
+  unsigned int grid_version_ = 0;
+
+  unsigned int add(glm::ivec2 pos);
+  unsigned int find(unsigned int i);
+  void unite(unsigned int a, unsigned int b);
+
+  // Gives every tile connected to `start` a fresh set with `start` as the
+  // root.
+  void relabel_from(glm::ivec2 start);
+
+public:
+  static constexpr unsigned int NO_REGION =
+    std::numeric_limits<unsigned int>::max();
+
+  void build(const Grid& grid);
+
+  // Catches up on the tiles changed since build() or the last update(). A
+  // tile becoming walkable only merges regions, but a wall going up may split
+  // one, which costs a flood fill of what's left of it.
+  void update(const Grid& grid);
+
+  // NO_REGION if the tile isn't walkable. Labels are only good for comparing
+  // against each other; they may change whenever the grid does.
+  unsigned int region(glm::ivec2 pos) const;
+
+  bool connected(glm::ivec2 a, glm::ivec2 b) const {
+    unsigned int r = region(a);
+    return r != NO_REGION && r == region(b);
+  }
+};
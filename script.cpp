@@ -1,5 +1,7 @@
 #include "script.h"
 
+#include "combat.h"
+#include "flow.h"
 #include "game.h"
 
 void Script::push(ScriptFn fn) { instructions_.push_back(std::move(fn)); }
@@ -197,6 +199,97 @@ void push_move_along_path(Script& script, EntityId id, Path _path,
   });
 }
 
+void push_move_along_path(Script& script, EntityId id, PathHandle path,
+                          float tiles_per_second) {
+  using std::chrono::duration;
+  using std::chrono::seconds;
+
+  // The path isn't known until the script runs, so neither is how long it
+  // takes to walk.
+  script.push([path, watch=StopWatch(), started=false, id,
+               tiles_per_second](Game& game) mutable {
+      Transform* transform = nullptr;
+      if (game.ecs().read(id, &transform) != EcsError::OK) {
+        std::cerr << "Move script interrupted: entity stopped existing."
+                  << std::endl;
+        game.paths().release(path);
+        return ScriptResult::CONTINUE;
+      }
+      if (!game.paths().valid(path) || game.paths().get(path).empty()) {
+        game.paths().release(path);
+        return ScriptResult::CONTINUE;
+      }
+
+      const Path& tiles = game.paths().get(path);
+      if (!started) {
+        started = true;
+        watch = StopWatch(duration<float, seconds::period>(
+                path_distance(tiles) / tiles_per_second));
+        watch.start();
+      }
+
+      watch.consume(game.dt());
+
+      auto to_float = [](glm::vec2 v) { return v; };
+      transform->pos = mix_vector_by_ratio(tiles, watch.ratio_consumed(),
+                                           to_float);
+
+      if (watch.finished()) {
+        GridPos* gpos = nullptr;
+        if (game.ecs().read(id, &gpos) == EcsError::OK)
+          gpos->pos = glm::round(tiles.back());
+        game.paths().release(path);
+        return ScriptResult::CONTINUE;
+      }
+
+      return ScriptResult::WAIT;
+  });
+}
+
+void push_move_along_flow(Script& script, EntityId id,
+                          std::shared_ptr<const FlowField> field,
+                          unsigned int max_steps, float tiles_per_second) {
+  using std::chrono::duration;
+  using std::chrono::seconds;
+
+  struct Walk {
+    unsigned int steps = 0;
+    Path leg;  // From the last tile to the one being stepped onto.
+    StopWatch watch;
+  };
+
+  script.push([walk=Walk(), id, field=std::move(field), max_steps,
+               tiles_per_second](Game& game) mutable {
+      Transform* transform = nullptr;
+      GridPos* gpos = nullptr;
+      if (game.ecs().read(id, &transform, &gpos) != EcsError::OK) {
+        std::cerr << "Flow script interrupted: entity stopped existing."
+                  << std::endl;
+        return ScriptResult::CONTINUE;
+      }
+
+      if (walk.leg.empty()) {
+        const glm::ivec2 from = gpos->pos;
+        if (walk.steps == max_steps ||
+            !step_along_flow(game.ecs(), *field, id))
+          return ScriptResult::CONTINUE;
+        walk.leg = {from, gpos->pos};
+        ++walk.steps;
+        walk.watch = StopWatch(duration<float, seconds::period>(
+                1.0f / tiles_per_second));
+        walk.watch.start();
+      }
+
+      walk.watch.consume(game.dt());
+      auto to_float = [](glm::vec2 v) { return v; };
+      transform->pos = mix_vector_by_ratio(walk.leg,
+                                           walk.watch.ratio_consumed(),
+                                           to_float);
+      if (walk.watch.finished()) walk.leg.clear();
+      return ScriptResult::WAIT;
+  });
+}
+
 void push_hp_change(Script& script, EntityId id, int change,
                     StatusEffect effect) {
   script.push([=](Game& game) {
@@ -207,11 +300,7 @@ void push_hp_change(Script& script, EntityId id, int change,
         return ScriptResult::CONTINUE;
       }
 
-      actor->add_status(effect);
-
-      int change_ = std::min(change, int(actor->hp));
-      actor->hp -= change_;
-      actor->hp = std::min(actor->hp, actor->stats.max_hp);
+      change_hp(*actor, change, effect);
 
       // Spawn a "-X" to appear over the entity.
       GridPos x_pos{pos->pos + glm::ivec2(0, 1)};
@@ -246,17 +335,13 @@ void push_attack(Script& script, const Game& game, EntityId attacker,
   // Where to center the camera
   glm::vec2 cam_focus = glm::mix(attacker_pos, defender_pos, 0.5f);
 
-  // Calculate damage.
-  const Actor& defender_actor = game.ecs().read_or_panic<Actor>(defender);
+  // What happens is settled now; the rest is showing it.
+  const AttackOutcome outcome = resolve_attack(game, attacker, defender);
   const Actor& attacker_actor = game.ecs().read_or_panic<Actor>(attacker);
-  int damage = std::min(attacker_actor.stats.strength -
-                        defender_actor.stats.defense,
-                        defender_actor.hp);
-  damage = std::max(damage, 1);
 
   push_set_camera_target(script, cam_focus);
   push_move_along_path(script, attacker, {attacker_pos, thrust_pos}, 5.f);
-  push_hp_change(script, defender, damage, attacker_actor.embue);
+  push_hp_change(script, defender, outcome.damage, outcome.status);
 
   if (const Script* s = attacker_actor.triggers.get_or_null("on_hit_enemy")) {
     script.push([s](Game& game) {
@@ -265,8 +350,19 @@ void push_attack(Script& script, const Game& game, EntityId attacker,
     });
   }
 
-  if (attacker_actor.lifesteal) {
-    push_hp_change(script, attacker, -damage, StatusEffect());
+  if (!outcome.knockback.empty()) {
+    Script knockback;
+    push_move_along_path(knockback, defender,
+                         Path(outcome.knockback.begin(),
+                              outcome.knockback.end()));
+    script.push([knockback](Game& game) {
+        game.add_ordered_script(knockback);
+        return ScriptResult::CONTINUE;
+    });
+  }
+
+  if (outcome.healed) {
+    push_hp_change(script, attacker, -int(outcome.healed), StatusEffect());
   }
 
   push_move_along_path(script, attacker, {thrust_pos, attacker_pos}, 5.f);
@@ -1,14 +1,17 @@
 #pragma once
 
 #include <functional>
+#include <memory>
 #include <string_view>
 #include <unordered_map>
 #include <vector>
 
+#include "paths.h"
 #include "ui.h"
 
 // Forward decl because of mutual references between Script and Game.
 class Game;
+class FlowField;
 
 // For movement scripts from point A to B with any number of intermediate
 // points.
@@ -125,6 +128,20 @@ void push_set_camera_target(Script& script, glm::vec2 pos);
 void push_move_along_path(Script& script, EntityId id, Path path,
                           float tiles_per_second = 5.0f);
 
+// The same, but walks a path in the game's PathPool instead of keeping its own
+// copy, and releases it once done.
+void push_move_along_path(Script& script, EntityId id, PathHandle path,
+                          float tiles_per_second = 5.0f);
+
+// Like push_move_along_path(), but each step is read off a flow field shared
+// with everyone else heading the same way. Takes up to `max_steps` steps and
+// stops early at a goal or if someone's in the way. The tile being stepped
+// onto is claimed as the step starts, so that a crowd doesn't pile onto it.
+void push_move_along_flow(Script& script, EntityId id,
+                          std::shared_ptr<const FlowField> field,
+                          unsigned int max_steps,
+                          float tiles_per_second = 5.0f);
+
 // Changes an entities health, making a nice "-X" appear on the screen to
 // inform the player.
 struct StatusEffect;
@@ -0,0 +1,179 @@
+#include <vector>
+
+#include "../ai.h"
+#include "../flow.h"
+#include "test.h"
+
+// A stand-in for the parts of a Game that a snapshot points to.
+struct World {
+  Grid grid;
+  RegionMap regions;
+  PathHierarchy hierarchy;
+  ThreatMap threats;
+  UnitBuckets buckets;
+  DijkstraGrid moves;
+  FlowField enemy_flow;
+  WorldSnapshot snapshot;
+
+  World(Grid g, std::vector<WorldSnapshot::Unit> units, EntityId actor)
+    : grid(std::move(g)) {
+    regions.build(grid);
+    hierarchy.build(grid);
+
+    std::vector<ThreatMap::Unit> threat_units;
+    std::vector<UnitBuckets::Unit> bucket_units;
+    std::vector<Occupant> occupants;
+    std::vector<glm::ivec2> enemies;
+    const WorldSnapshot::Unit* me = nullptr;
+    for (const WorldSnapshot::Unit& u : units) {
+      threat_units.push_back({u.id, u.pos, u.team, int(u.stats.move),
+                              int(u.stats.range), int(u.stats.strength)});
+      bucket_units.push_back({u.id, u.pos, u.team});
+      occupants.emplace_back(u.pos, u.id);
+      if (u.id == actor) me = &u;
+    }
+    for (const WorldSnapshot::Unit& u : units)
+      if (u.team != me->team) enemies.push_back(u.pos);
+    threats.update(grid.bounds_min(), grid.bounds_max(), threat_units);
+    buckets.update(grid.bounds_min(), grid.bounds_max(), bucket_units);
+    moves.generate(grid, occupants, me->pos, me->stats.move);
+    enemy_flow.generate(grid, enemies);
+
+    snapshot.units = std::move(units);
+    snapshot.grid = &grid;
+    snapshot.regions = &regions;
+    snapshot.hierarchy = &hierarchy;
+    snapshot.threats = &threats;
+    snapshot.buckets = &buckets;
+    snapshot.moves = &moves;
+    snapshot.enemy_flow = &enemy_flow;
+  }
+};
+
+int main() {
+  Tile floor{.walkable = true, .glyph = '.'};
+  Tile wall{.walkable = false, .opaque = true, .glyph = '#'};
+  Grid grid = arena_grid({20, 12}, wall, floor);
+
+  Stats stats;
+  stats.move = 3;
+  stats.range = 1;
+  const EntityId cpu{1}, player{2};
+
+  // Steps up next to the player, ready to attack.
+  World world(grid, {{cpu, {2, 5}, Team::CPU, stats, stats.max_hp, 0},
+                     {player, {6, 5}, Team::PLAYER, stats, stats.max_hp, 0}},
+              cpu);
+  VisionCache vision;
+  Decision d = cpu_decide(world.snapshot, cpu, vision);
+  TEST(d.type, Decision::MOVE_TO);
+  TEST(d.move_to == glm::ivec2(5, 5), true);
+
+  // Once there, attacks.
+  World close(grid, {{cpu, {5, 5}, Team::CPU, stats, stats.max_hp, 0},
+                     {player, {6, 5}, Team::PLAYER, stats, stats.max_hp, 0}},
+              cpu);
+  d = cpu_decide(close.snapshot, cpu, vision);
+  TEST(d.type, Decision::ATTACK_ENTITY);
+  TEST(d.target == player, true);
+
+  // Badly hurt, backs off out of reach instead, given the legs for it.
+  Stats quick = stats;
+  quick.move = 5;
+  World hurt(grid, {{cpu, {5, 5}, Team::CPU, quick, 1, 0},
+                    {player, {6, 5}, Team::PLAYER, stats, stats.max_hp, 0}},
+             cpu);
+  hurt.snapshot.turn.did_action = true;
+  d = cpu_decide(hurt.snapshot, cpu, vision);
+  TEST(d.type, Decision::MOVE_TO);
+  TEST(d.type == Decision::MOVE_TO &&
+       hurt.threats.threat_to(Team::CPU, d.move_to) <
+       hurt.threats.threat_to(Team::CPU, {5, 5}), true);
+
+  // Nothing left to do.
+  close.snapshot.turn.did_action = close.snapshot.turn.did_move = true;
+  TEST(cpu_decide(close.snapshot, cpu, vision).type, Decision::PASS);
+
+  // Out of time before starting, the planner falls back on cpu_decide().
+  AnytimePlanner planner;
+  planner.begin(world.snapshot, cpu, vision);
+  TEST(planner.search(AnytimePlanner::Clock::now()), false);
+  TEST(planner.depth(), 0u);
+  TEST(planner.best().type, Decision::MOVE_TO);
+  TEST(planner.best().move_to == glm::ivec2(5, 5), true);
+
+  // Given time, it looks as far ahead as it ever does, a bit at a time.
+  close.snapshot.turn.did_action = close.snapshot.turn.did_move = false;
+  planner.begin(close.snapshot, cpu, vision);
+  while (!planner.search(AnytimePlanner::Clock::now() +
+                         std::chrono::microseconds(50))) { }
+  TEST(planner.depth(), AnytimePlanner::MAX_DEPTH);
+  TEST(planner.best().type, Decision::ATTACK_ENTITY);
+  TEST(planner.n_evaluated() > 0, true);
+
+  // It goes for the kill where cpu_decide() hits whoever comes first.
+  const EntityId weak{3};
+  World two(grid, {{cpu, {5, 5}, Team::CPU, stats, stats.max_hp, 0},
+                   {player, {6, 5}, Team::PLAYER, stats, stats.max_hp, 0},
+                   {weak, {4, 5}, Team::PLAYER, stats, 1, 0}},
+            cpu);
+  TEST(cpu_decide(two.snapshot, cpu, vision).target == player, true);
+  planner.begin(two.snapshot, cpu, vision);
+  planner.search(AnytimePlanner::Clock::now() + std::chrono::seconds(1));
+  TEST(planner.best().type, Decision::ATTACK_ENTITY);
+  TEST(planner.best().target == weak, true);
+
+  // So does the tree search, on however many threads.
+  MonteCarloPlanner monte_carlo(2);
+  d = monte_carlo.decide(two.snapshot, cpu, vision,
+                         MonteCarloPlanner::Clock::now() +
+                         std::chrono::milliseconds(100));
+  TEST(d.type == Decision::ATTACK_ENTITY && d.target == weak, true);
+  TEST(monte_carlo.n_rollouts() > 0, true);
+  TEST(monte_carlo.rollouts_per_sec() > 0, true);
+
+  // Without the time for a single rollout, it falls back on cpu_decide().
+  d = monte_carlo.decide(world.snapshot, cpu, vision,
+                         MonteCarloPlanner::Clock::now());
+  TEST(d.type, Decision::MOVE_TO);
+  TEST(d.move_to == glm::ivec2(5, 5), true);
+  TEST(monte_carlo.n_rollouts(), 0u);
+
+  // The worker comes to the same conclusions, one at a time, and can be
+  // started again as soon as a decision's been picked up.
+  AiWorker ai;
+  bool same = true;
+  for (int i = 0; i < 50; ++i) {
+    World& w = i % 2 ? world : close;
+    w.snapshot.turn = Turn();
+    TEST(ai.idle(), true);
+    ai.start(w.snapshot, cpu);
+    Decision got;
+    while (!ai.poll(got)) { }
+    Decision expected = cpu_decide(w.snapshot, cpu, vision);
+    same = same && got.type == expected.type;
+  }
+  TEST(same, true);
+
+  // With a budget, the worker's decisions come from the planner.
+  AiWorker thinker(std::chrono::milliseconds(20));
+  thinker.start(two.snapshot, cpu);
+  Decision planned;
+  while (!thinker.poll(planned)) { }
+  TEST(planned.type == Decision::ATTACK_ENTITY && planned.target == weak,
+       true);
+
+  AiWorker searcher(std::chrono::milliseconds(100), AiWorker::MONTE_CARLO);
+  searcher.start(two.snapshot, cpu);
+  while (!searcher.poll(planned)) { }
+  TEST(planned.type == Decision::ATTACK_ENTITY && planned.target == weak,
+       true);
+  TEST(searcher.monte_carlo().n_rollouts() > 0, true);
+
+  // Cancelling throws away the answer, if there was one.
+  ai.start(world.snapshot, cpu);
+  ai.cancel();
+  TEST(ai.idle(), true);
+  Decision none;
+  TEST(ai.poll(none), false);
+}
@@ -0,0 +1,50 @@
+#include "../astar.h"
+#include "test.h"
+
+const char* const ROOMS = R"(
+#########
+#...#...#
+#...#...#
+#.......#
+#########)";
+
+int main() {
+  Tile floor{.walkable = true, .glyph = '.'};
+  Tile wall{.walkable = false, .opaque = true, .glyph = '#'};
+  Grid grid = grid_from_string(ROOMS, {{'.', floor}, {'#', wall}});
+
+  // The top row is y = 3 and the gap is along the bottom, y = 1.
+  AStar astar;
+  std::vector<glm::ivec2> path;
+  TEST(astar.find_path(grid, {}, {1, 3}, {7, 3}, path), true);
+  TEST(path.size(), 11u);
+  TEST(path.front() == glm::ivec2(1, 3) && path.back() == glm::ivec2(7, 3),
+       true);
+
+  bool connected = true;
+  for (std::size_t i = 0; i + 1 < path.size(); ++i)
+    connected = connected && manh_dist(path[i], path[i + 1]) == 1;
+  TEST(connected, true);
+
+  TEST(astar.find_path(grid, {}, {1, 3}, {0, 0}, path), false);
+  TEST(path.empty(), true);
+  TEST(astar.find_path(grid, {}, {2, 2}, {2, 2}, path), true);
+  TEST(path.size(), 1u);
+
+  // Someone standing in the gap blocks it, unless they're who we're after.
+  std::vector<Occupant> units = {{{4, 1}, EntityId{3}}};
+  TEST(astar.find_path(grid, units, {1, 3}, {7, 3}, path), false);
+  TEST(astar.find_path(grid, units, {1, 3}, {4, 1}, path), true);
+  TEST(path.size(), 6u);
+
+  // Mud only matters when counting move costs.
+  grid.at({2, 1}).move_cost = 9;
+  TEST(astar.find_path(grid, {}, {1, 1}, {4, 1}, path), true);
+  TEST(path.size(), 4u);
+
+  AStar weighted(PathCosts::MOVE_COST);
+  TEST(weighted.find_path(grid, {}, {1, 1}, {4, 1}, path), true);
+  TEST(path.size(), 6u);
+  TEST(std::find(path.begin(), path.end(), glm::ivec2(2, 1)) == path.end(),
+       true);
+}
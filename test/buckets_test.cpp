@@ -0,0 +1,58 @@
+#include <algorithm>
+#include <vector>
+
+#include "../buckets.h"
+#include "math.h"
+#include "random.h"
+#include "test.h"
+
+int main() {
+  UnitBuckets buckets;
+  std::vector<UnitBuckets::Unit> units = {
+    {EntityId{1}, {5, 5}, Team::PLAYER},
+    {EntityId{2}, {7, 6}, Team::CPU},
+    {EntityId{3}, {9, 5}, Team::CPU},
+    {EntityId{4}, {4, 4}, Team::PLAYER},
+  };
+  buckets.update({0, 0}, {20, 20}, units);
+
+  std::vector<EntityId> near;
+  buckets.enemies_within(Team::PLAYER, {5, 5}, 2, near);
+  TEST(near.size(), 1u);
+  TEST(near.size() && near[0].id == 2, true);
+  buckets.enemies_within(Team::CPU, {8, 5}, 4, near);
+  TEST(near.size(), 2u);
+  buckets.enemies_within(Team::PLAYER, {15, 15}, 2, near);
+  TEST(near.size(), 0u);
+
+  // Units and queries off the edge of the map still count.
+  units.push_back({EntityId{5}, {-3, 25}, Team::CPU});
+  buckets.update({0, 0}, {20, 20}, units);
+  buckets.enemies_within(Team::PLAYER, {-1, 24}, 2, near);
+  TEST(near.size(), 1u);
+
+  // The same answers as asking every unit, on a map of several cells.
+  units.clear();
+  for (unsigned int i = 0; i < 300; ++i)
+    units.push_back({EntityId{i + 1},
+                     {int(hash_coords(1, i, 0) % 70) - 3,
+                      int(hash_coords(2, i, 0) % 50)},
+                     i % 3 ? Team::CPU : Team::PLAYER});
+  buckets.update({0, 0}, {64, 50}, units);
+  bool same = true;
+  for (int q = 0; q < 200; ++q) {
+    glm::ivec2 pos(hash_coords(3, q, 0) % 64, hash_coords(4, q, 0) % 50);
+    unsigned int range = hash_coords(5, q, 0) % 12;
+    Team team = q % 2 ? Team::CPU : Team::PLAYER;
+    buckets.enemies_within(team, pos, range, near);
+
+    std::vector<unsigned int> got, expected;
+    for (EntityId id : near) got.push_back(id.id);
+    for (const UnitBuckets::Unit& u : units)
+      if (u.team != team && diamond_dist(u.pos, pos) <= range)
+        expected.push_back(u.id.id);
+    std::sort(got.begin(), got.end());
+    same = same && got == expected;
+  }
+  TEST(same, true);
+}
@@ -0,0 +1,77 @@
+#include "../combat.h"
+#include "../mapgen.h"
+#include "test.h"
+
+int main() {
+  Stats stats;  // Strength 5, defense 3.
+  TEST(attack_damage(stats, stats, 10), 2u);
+  TEST(attack_damage(stats, stats, 1), 1u);
+  Stats tough = stats;
+  tough.defense = 9;
+  TEST(attack_damage(stats, tough, 10), 1u);
+
+  Tile floor{.walkable = true, .glyph = '.'};
+  Tile wall{.walkable = false, .opaque = true, .glyph = '#'};
+  Grid grid = arena_grid({10, 10}, wall, floor);
+  AStar path_finder(PathCosts::MOVE_COST);
+
+  Ecs ecs;
+  const EntityId attacker =
+    ecs.write_new_entity(GridPos{{2, 2}}, Actor("attacker", stats));
+  const EntityId defender =
+    ecs.write_new_entity(GridPos{{3, 2}}, Actor("defender", stats));
+  auto actor = [&](EntityId id) -> Actor& {
+    return ecs.read_or_panic<Actor>(id);
+  };
+
+  AttackOutcome outcome =
+    resolve_attack(ecs, grid, path_finder, attacker, defender);
+  TEST(outcome.damage, 2u);
+  TEST(outcome.healed, 0u);
+  TEST(outcome.knockback.empty(), true);
+  apply_attack(ecs, outcome);
+  TEST(actor(defender).hp, stats.max_hp - 2);
+  TEST(actor(defender).statuses.empty(), true);
+
+  // Statuses, healing that stops at max_hp, and a push one tile back.
+  actor(attacker).embue.slowed = true;
+  actor(attacker).embue.ticks_left = 10;
+  actor(attacker).lifesteal = true;
+  actor(attacker).knockback = true;
+  actor(attacker).hp = stats.max_hp - 1;
+  outcome = resolve_attack(ecs, grid, path_finder, attacker, defender);
+  TEST(outcome.healed, 1u);
+  TEST(outcome.knockback.size(), 2u);
+  apply_attack(ecs, outcome);
+  TEST(actor(defender).hp, stats.max_hp - 4);
+  TEST(actor(defender).stats.speed, stats.speed / 2);
+  TEST(actor(attacker).hp, stats.max_hp);
+  TEST(ecs.read_or_panic<GridPos>(defender).pos == glm::ivec2(4, 2), true);
+
+  // Nobody gets knocked into someone else.
+  ecs.write_new_entity(GridPos{{5, 2}}, Actor("bystander", stats));
+  Decision attack;
+  attack.type = Decision::ATTACK_ENTITY;
+  attack.target = defender;
+  ecs.read_or_panic<GridPos>(attacker).pos = {3, 2};
+  Resolution resolution =
+    resolve_decision(ecs, grid, path_finder, attacker, attack);
+  TEST(resolution.attack.knockback.empty(), true);
+  apply_decision(ecs, resolution);
+  TEST(actor(defender).hp, stats.max_hp - 6);
+  TEST(ecs.read_or_panic<GridPos>(defender).pos == glm::ivec2(4, 2), true);
+
+  // Moving just moves; passing does nothing.
+  Decision move;
+  move.type = Decision::MOVE_TO;
+  move.move_to = {3, 5};
+  apply_decision(ecs,
+                 resolve_decision(ecs, grid, path_finder, attacker, move));
+  TEST(ecs.read_or_panic<GridPos>(attacker).pos == glm::ivec2(3, 5), true);
+  Decision pass;
+  pass.type = Decision::PASS;
+  apply_decision(ecs,
+                 resolve_decision(ecs, grid, path_finder, attacker, pass));
+  TEST(ecs.read_or_panic<GridPos>(attacker).pos == glm::ivec2(3, 5), true);
+  TEST(actor(defender).hp, stats.max_hp - 6);
+}
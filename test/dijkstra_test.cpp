@@ -0,0 +1,277 @@
+#include "../dijkstra.h"
+#include "random.h"
+#include "test.h"
+
+const char* const ROOM = R"(
+#######
+#.....#
+#.#####
+#.....#
+#######)";
+
+int main() {
+  Tile floor{.walkable = true, .glyph = '.'};
+  Tile wall{.walkable = false, .opaque = true, .glyph = '#'};
+  Grid grid = grid_from_string(ROOM, {{'.', floor}, {'#', wall}});
+
+  // The top row is y = 3 and the bottom, y = 1.
+  DijkstraGrid dijkstra;
+  dijkstra.generate(grid, {}, {5, 3});
+  TEST(dijkstra.size(), 11u);
+  TEST(dijkstra.contains({0, 0}), false);
+  TEST(dijkstra.contains({2, 2}), false);
+  TEST(dijkstra.contains({100, 100}), false);
+  TEST(dijkstra.at({5, 1}).dist, 10u);
+  TEST(ipath_to(dijkstra, {1, 1}).size(), 7u);
+  TEST(rewind_until(dijkstra, {5, 1},
+                    [](glm::ivec2, const DijkstraNode& node) {
+                      return node.dist <= 3;
+                    }) == glm::ivec2(2, 3), true);
+
+  // Nodes come out closest first.
+  unsigned int last_dist = 0;
+  bool in_order = true;
+  for (const auto& [pos, node] : dijkstra) {
+    in_order = in_order && node.dist >= last_dist;
+    last_dist = node.dist;
+  }
+  TEST(in_order, true);
+
+  // Bounded floods stop early.
+  dijkstra.generate(grid, {}, {5, 3}, 4);
+  TEST(dijkstra.size(), 5u);
+  TEST(dijkstra.contains({1, 3}), true);
+  TEST(dijkstra.contains({1, 2}), false);
+
+  auto [found, ok] = dijkstra.generate_until(
+      grid, {}, {5, 3},
+      [](glm::ivec2 pos, const DijkstraNode&) { return pos.y == 1; });
+  TEST(ok && found == glm::ivec2(1, 1), true);
+  TEST(dijkstra.contains({2, 1}), false);
+
+  TEST(dijkstra.generate_until(
+           grid, {}, {5, 3},
+           [](glm::ivec2 pos, const DijkstraNode&) { return pos.y == 0; })
+       .second, false);
+  TEST(dijkstra.size(), 11u);
+
+  // Mud in the corridor makes it cost more, but it's still the only way.
+  DijkstraGrid weighted(PathCosts::MOVE_COST);
+  grid.at({1, 2}).move_cost = 5;
+  weighted.generate(grid, {}, {5, 3});
+  TEST(weighted.at({1, 2}).dist, 9u);
+  TEST(weighted.at({5, 1}).dist, 14u);
+  TEST(ipath_to(weighted, {5, 1}).size(), 11u);
+  TEST(rewind_until(weighted, {5, 1},
+                    [](glm::ivec2, const DijkstraNode& node) {
+                      return node.dist <= 8;
+                    }) == glm::ivec2(1, 3), true);
+
+  weighted.generate(grid, {}, {5, 3}, 8);
+  TEST(weighted.size(), 5u);
+  grid.at({1, 2}).move_cost = 1;
+
+  // A unit in the corridor is reached, but nothing past it is.
+  std::vector<Occupant> units = {{{1, 2}, EntityId{7}}};
+  dijkstra.generate(grid, units, {5, 3});
+  TEST(dijkstra.at({1, 2}).entity.id, 7u);
+  TEST(dijkstra.contains({1, 1}), false);
+
+  // Unless it's the one moving.
+  dijkstra.generate(grid, units, {1, 2});
+  TEST(dijkstra.size(), 11u);
+  TEST(dijkstra.at({1, 1}).entity.id, 0u);
+
+  // The unit steps down the corridor and the field is repaired.
+  dijkstra.generate(grid, units, {5, 3});
+  units[0].first = {2, 1};
+  std::vector<glm::ivec2> moved = {{1, 2}, {2, 1}};
+  dijkstra.repair(grid, units, moved);
+  TEST(dijkstra.size(), 8u);
+  TEST(dijkstra.at({1, 1}).dist, 6u);
+  TEST(dijkstra.at({2, 1}).entity.id, 7u);
+  TEST(dijkstra.contains({3, 1}), false);
+
+  // With two sources, each tile is as far as the closer one.
+  std::vector<glm::ivec2> ends = {{5, 3}, {5, 1}};
+  dijkstra.generate(grid, {}, ends);
+  TEST(dijkstra.size(), 11u);
+  TEST(dijkstra.at({1, 3}).dist, 4u);
+  TEST(dijkstra.at({1, 1}).dist, 4u);
+  TEST(dijkstra.at({1, 2}).dist, 5u);
+
+  // Walking down it toward (5, 3), stopping next to it or when out of steps.
+  TEST(descend(dijkstra, {1, 3}, 10) == glm::ivec2(4, 3), true);
+  TEST(descend(dijkstra, {1, 3}, 2) == glm::ivec2(3, 3), true);
+  TEST(descend(dijkstra, {4, 3}, 10) == glm::ivec2(4, 3), true);
+
+  // Mud costs more to step onto, so it's harder to get far.
+  grid.at({3, 3}).move_cost = 3;
+  weighted.generate(grid, {}, ends);
+  TEST(weighted.at({1, 3}).dist, 6u);
+  TEST(descend(weighted, {1, 3}, 3) == glm::ivec2(2, 3), true);
+  TEST(descend(weighted, {1, 3}, 4) == glm::ivec2(3, 3), true);
+  grid.at({3, 3}).move_cost = 1;
+
+  // Units in the way stop it short.
+  std::vector<Occupant> blocker = {{{3, 3}, EntityId{9}}};
+  dijkstra.generate(grid, blocker, ends);
+  TEST(dijkstra.at({1, 3}).dist, 6u);
+  TEST(descend(dijkstra, {1, 3}, 10) == glm::ivec2(4, 1), true);
+
+  // Fields made on worker threads are the same as any others.
+  FieldPrefetch prefetch(PathCosts::STEPS, 3);
+  std::vector<FieldPrefetch::Request> requests = {
+    {{5, 3}}, {{1, 1}, 3}, {{1, 2}}, {{3, 1}, 1}, {{0, 0}}};
+  prefetch.start(grid, units, requests);
+  prefetch.wait();
+  TEST(prefetch.size(), requests.size());
+  bool same_fields = true;
+  for (std::size_t i = 0; i < requests.size(); ++i) {
+    dijkstra.generate(grid, units, requests[i].source, requests[i].max_dist);
+    same_fields = same_fields &&
+                  prefetch.field(i).size() == dijkstra.size();
+    for (const auto& [pos, node] : dijkstra)
+      same_fields = same_fields && prefetch.field(i).contains(pos) &&
+                    prefetch.field(i).at(pos).dist == node.dist;
+  }
+  TEST(same_fields, true);
+
+  // Repairs match starting over, whatever changes.
+  const Tile mud{.walkable = true, .move_cost = 3, .glyph = '~'};
+  for (PathCosts costs : {PathCosts::STEPS, PathCosts::MOVE_COST}) {
+    for (unsigned int max_dist : {DijkstraGrid::UNBOUNDED, 12u}) {
+      Grid cave = arena_grid({24, 24}, wall, floor);
+      DijkstraGrid repaired(costs), fresh(costs);
+      std::vector<Occupant> crowd;
+      for (unsigned int i = 0; i < 8; ++i)
+        crowd.emplace_back(glm::ivec2(1 + hash_coords(4, i, 0) % 22,
+                                      1 + hash_coords(4, i, 1) % 22),
+                           EntityId{i + 1});
+      repaired.generate(cave, crowd, {12, 12}, max_dist);
+
+      bool same = true;
+      for (int round = 0; round < 40; ++round) {
+        std::vector<glm::ivec2> changed;
+        for (int j = 0; j < 3; ++j) {
+          glm::ivec2 p(1 + hash_coords(5, round, j) % 22,
+                       1 + hash_coords(6, round, j) % 22);
+          if (p == glm::ivec2(12, 12)) continue;
+          const Tile* tiles[] = {&floor, &wall, &mud};
+          cave.set(p, *tiles[hash_coords(7, round, j) % 3]);
+          changed.push_back(p);
+        }
+        Occupant& unit = crowd[round % crowd.size()];
+        changed.push_back(unit.first);
+        unit.first = {1 + hash_coords(8, round, 0) % 22,
+                      1 + hash_coords(8, round, 1) % 22};
+        changed.push_back(unit.first);
+
+        repaired.repair(cave, crowd, changed);
+        fresh.generate(cave, crowd, {12, 12}, max_dist);
+        same = same && repaired.size() == fresh.size();
+        for (const auto& [pos, node] : fresh)
+          same = same && repaired.contains(pos) &&
+                 repaired.at(pos).dist == node.dist &&
+                 repaired.at(pos).entity.id == node.entity.id;
+      }
+      TEST(same, true);
+    }
+  }
+
+  // The FieldCache, with a log of who changed standing in for the Game's.
+  Grid arena = arena_grid({16, 16}, wall, floor);
+  std::vector<Occupant> standing = {{{4, 4}, EntityId{1}},
+                                    {{9, 9}, EntityId{2}}};
+  std::vector<glm::ivec2> changed;
+  auto get = [&](FieldCache& cache,
+                 glm::ivec2 source) -> const DijkstraGrid& {
+    return cache.get(arena, standing, changed, changed.size(), source);
+  };
+  auto same_as_fresh = [&](const DijkstraGrid& field, glm::ivec2 source) {
+    DijkstraGrid fresh;
+    fresh.generate(arena, standing, source);
+    bool same = field.size() == fresh.size();
+    for (const auto& [pos, node] : fresh)
+      same = same && field.contains(pos) && field.at(pos).dist == node.dist;
+    return same;
+  };
+
+  FieldCache cache(PathCosts::STEPS, 1 << 30);
+  const DijkstraGrid* field = &get(cache, {2, 2});
+  TEST(cache.n_misses(), 1u);
+  TEST(&get(cache, {2, 2}) == field, true);
+  TEST(cache.n_hits(), 1u);
+
+  // Someone moving or a tile changing means a repair, not starting over.
+  changed.push_back(standing[1].first);
+  standing[1].first = {3, 2};
+  changed.push_back(standing[1].first);
+  TEST(same_as_fresh(get(cache, {2, 2}), {2, 2}), true);
+  TEST(cache.n_repairs(), 1u);
+  arena.set({2, 5}, wall);
+  TEST(same_as_fresh(get(cache, {2, 2}), {2, 2}), true);
+  TEST(cache.n_repairs(), 2u);
+  TEST(cache.n_misses(), 1u);
+
+  get(cache, {12, 12});
+  TEST(cache.n_misses(), 2u);
+  TEST(cache.size(), 2u);
+
+  // Over budget, the least recently used goes first.
+  FieldCache small(PathCosts::STEPS, 1 << 30);
+  get(small, {2, 2});
+  const std::size_t budget = small.bytes() * 5 / 2;
+  small = FieldCache(PathCosts::STEPS, budget);
+  get(small, {2, 2});
+  get(small, {12, 12});
+  get(small, {2, 2});
+  get(small, {7, 12});
+  TEST(small.size(), 2u);
+  TEST(small.bytes() <= budget, true);
+  get(small, {2, 2});
+  TEST(small.n_hits(), 2u);
+  get(small, {12, 12});
+  TEST(small.n_misses(), 4u);
+
+  // A full cache hands the field it drops to the new source, buffers and all.
+  FieldCache one(PathCosts::STEPS, 0);
+  field = &get(one, {2, 2});
+  const std::size_t bytes = one.bytes();
+  TEST(&get(one, {12, 12}) == field, true);
+  TEST(one.size(), 1u);
+  TEST(one.bytes(), bytes);
+  TEST(same_as_fresh(*field, {12, 12}), true);
+
+  // Adopting a field replaces whatever had the same source and max_dist.
+  DijkstraGrid blocked;
+  std::vector<Occupant> crowded = standing;
+  crowded.emplace_back(glm::ivec2(13, 12), EntityId{3});
+  blocked.generate(arena, crowded, {12, 12});
+  blocked.set_versions(arena.version(), changed.size());
+  const unsigned int blocked_dist = blocked.at({14, 12}).dist;
+  TEST(blocked_dist > get(cache, {12, 12}).at({14, 12}).dist, true);
+  cache.adopt({12, 12}, DijkstraGrid::UNBOUNDED, std::move(blocked));
+  TEST(cache.size(), 2u);
+  TEST(get(cache, {12, 12}).at({14, 12}).dist, blocked_dist);
+  TEST(cache.n_hits(), 3u);
+
+  // Only the changes since a field was last brought up to date are needed.
+  // If they don't go back that far, it starts over.
+  get(cache, {2, 2});
+  const unsigned int version = changed.size();
+  changed.push_back(standing[0].first);
+  standing[0].first = {2, 4};
+  changed.push_back(standing[0].first);
+  field = &cache.get(arena, standing, std::span(changed).subspan(version),
+                     changed.size(), {2, 2});
+  TEST(same_as_fresh(*field, {2, 2}), true);
+  TEST(field->patched(), true);
+  changed.push_back(standing[0].first);
+  standing[0].first = {1, 4};
+  changed.push_back(standing[0].first);
+  field = &cache.get(arena, standing, std::span(changed).last(1),
+                     changed.size(), {2, 2});
+  TEST(same_as_fresh(*field, {2, 2}), true);
+  TEST(field->patched(), false);
+}
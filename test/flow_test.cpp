@@ -0,0 +1,144 @@
+#include <algorithm>
+#include <tuple>
+
+#include "../flow.h"
+#include "random.h"
+#include "test.h"
+
+const char* const ROOM = R"(
+#######
+#.....#
+#.#####
+#.....#
+#######)";
+
+// Every step leads one tile closer, paying that tile's cost.
+static bool downhill(const FlowField& flow, const Grid& grid) {
+  const DijkstraGrid& field = flow.integration();
+  for (const auto& [pos, tile] : grid) {
+    if (flow.reaches(pos) != field.contains(pos)) return false;
+    auto [next, ok] = flow.next(pos);
+    if (!ok) {
+      if (field.contains(pos) && field.at(pos).dist != 0) return false;
+      continue;
+    }
+    if (field.at(pos).dist != field.at(next).dist + tile.move_cost)
+      return false;
+  }
+  return true;
+}
+
+int main() {
+  Tile floor{.walkable = true, .glyph = '.'};
+  Tile wall{.walkable = false, .opaque = true, .glyph = '#'};
+  Grid grid = grid_from_string(ROOM, {{'.', floor}, {'#', wall}});
+
+  // The top row is y = 3 and the bottom, y = 1.
+  FlowField flow;
+  std::vector<glm::ivec2> goal = {{5, 3}};
+  flow.generate(grid, goal);
+  TEST(flow.next({1, 1}).first == glm::ivec2(1, 2), true);
+  TEST(flow.next({1, 2}).first == glm::ivec2(1, 3), true);
+  TEST(flow.next({4, 3}).first == glm::ivec2(5, 3), true);
+  TEST(flow.next({5, 3}).second, false);
+  TEST(flow.at_goal({5, 3}), true);
+  TEST(flow.reaches({2, 2}), false);
+  TEST(flow.next({2, 2}).second, false);
+  TEST(flow.next({100, 100}).second, false);
+
+  // Walking from the far end gets there in as many steps as it's far.
+  glm::ivec2 pos = {5, 1};
+  int steps = 0;
+  for (auto [next, ok] = flow.next(pos); ok;
+       std::tie(next, ok) = flow.next(pos)) {
+    pos = next;
+    ++steps;
+  }
+  TEST(pos == glm::ivec2(5, 3), true);
+  TEST(steps, 10);
+
+  TEST(flow.follow({5, 1}, 3) == glm::ivec2(2, 1), true);
+  TEST(flow.follow({1, 3}, 10) == glm::ivec2(4, 3), true);
+
+  // Units in the way stop a unit short.
+  std::vector<Occupant> units = {{{1, 2}, EntityId{3}}};
+  flow.generate(grid, goal, units);
+  TEST(flow.follow({1, 3}, 10) == glm::ivec2(4, 3), true);
+  TEST(flow.reaches({1, 1}), false);
+
+  // Repairs keep every step pointing downhill, with the same distances as
+  // starting over.
+  const Tile mud{.walkable = true, .move_cost = 3, .glyph = '~'};
+  Grid arena = arena_grid({20, 20}, wall, floor);
+  std::vector<glm::ivec2> goals = {{3, 3}, {15, 12}};
+  FlowField repaired, fresh;
+  repaired.generate(arena, goals);
+  bool same = true;
+  for (int round = 0; round < 40; ++round) {
+    std::vector<glm::ivec2> changed;
+    for (int j = 0; j < 3; ++j) {
+      glm::ivec2 p(1 + hash_coords(5, round, j) % 18,
+                   1 + hash_coords(6, round, j) % 18);
+      if (p == goals[0] || p == goals[1]) continue;
+      const Tile* tiles[] = {&floor, &wall, &mud};
+      arena.set(p, *tiles[hash_coords(7, round, j) % 3]);
+      changed.push_back(p);
+    }
+    repaired.repair(arena, {}, changed);
+    fresh.generate(arena, goals);
+    same = same && downhill(repaired, arena);
+    for (const auto& [p, node] : fresh.integration())
+      same = same && repaired.reaches(p) &&
+             repaired.integration().at(p).dist == node.dist;
+  }
+  TEST(same, true);
+
+  // A crowd sharing one field takes turns stepping. Nobody steps onto a tile
+  // someone else has claimed, and whoever reaches the goal stays there.
+  Ecs ecs;
+  std::vector<EntityId> crowd;
+  for (int i = 0; i < 6; ++i)
+    crowd.push_back(ecs.write_new_entity(
+        GridPos{{1 + i * 3, 1 + (i % 2) * 17}}, Actor("crowd", Stats())));
+  FlowField shared;
+  shared.generate(arena_grid({20, 20}, wall, floor), goals);
+  auto apart = [&] {
+    std::vector<glm::ivec2> taken;
+    for (const auto& [id, gpos, unused_actor] :
+         ecs.read_all<GridPos, Actor>()) {
+      if (std::find(taken.begin(), taken.end(), gpos.pos) != taken.end())
+        return false;
+      taken.push_back(gpos.pos);
+    }
+    return true;
+  };
+  bool always_apart = true;
+  bool moving = true;
+  for (int round = 0; moving && round < 100; ++round) {
+    moving = false;
+    for (EntityId id : crowd) {
+      moving = step_along_flow(ecs, shared, id) || moving;
+      always_apart = always_apart && apart();
+    }
+  }
+  TEST(moving, false);
+  TEST(always_apart, true);
+
+  // Everyone's either on a goal or queued up behind someone.
+  int at_goal = 0;
+  bool queued = true;
+  for (EntityId id : crowd) {
+    glm::ivec2 pos = ecs.read_or_panic<GridPos>(id).pos;
+    if (shared.at_goal(pos)) {
+      ++at_goal;
+      continue;
+    }
+    auto [next, ok] = shared.next(pos);
+    bool blocked = false;
+    for (EntityId other : crowd)
+      blocked = blocked || ecs.read_or_panic<GridPos>(other).pos == next;
+    queued = queued && ok && blocked;
+  }
+  TEST(at_goal, 2);
+  TEST(queued, true);
+}
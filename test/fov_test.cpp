@@ -0,0 +1,42 @@
+#include "../fov.h"
+#include "test.h"
+
+const char* const ROOM = R"(
+#########
+#.......#
+#...#...#
+#.......#
+#########)";
+
+int main() {
+  Tile floor{.walkable = true, .glyph = '.'};
+  Tile wall{.walkable = false, .opaque = true, .glyph = '#'};
+  Grid grid = grid_from_string(ROOM, {{'.', floor}, {'#', wall}});
+
+  // The string is read top down, so the pillar is at <4, 2>.
+  VisibilitySet visible;
+  compute_fov(grid, {2, 2}, 8, visible);
+  TEST(visible.contains({2, 2}), true);
+  TEST(visible.contains({4, 2}), true);  // The pillar itself...
+  TEST(visible.contains({6, 2}), false);  // ...hides what's behind it.
+  TEST(visible.contains({6, 1}), true);
+  TEST(visible.contains({0, 2}), true);  // Walls are seen...
+  TEST(visible.contains({2, -1}), false);  // ...but not past.
+  TEST(visible.contains({20, 2}), false);  // Out of the radius entirely.
+
+  TEST_WITH(compute_fov(grid, {2, 2}, 1, visible),
+            visible.contains({4, 2}), false);
+
+  VisionCache cache;
+  EntityId id{1};
+  cache.get(grid, id, {2, 2}, 8);
+  TEST_WITH(cache.get(grid, id, {2, 2}, 8),
+            cache.n_computed(), 1u);
+  TEST_WITH(grid.set({4, 2}, floor),
+            cache.get(grid, id, {2, 2}, 8).contains({6, 2}), true);
+  TEST(cache.n_computed(), 2u);
+  TEST_WITH(grid.set({100, 100}, floor); cache.get(grid, id, {2, 2}, 8),
+            cache.n_computed(), 2u);
+  TEST_WITH(cache.get(grid, id, {3, 2}, 8),
+            cache.n_computed(), 3u);
+}
@@ -0,0 +1,19 @@
+#include <vector>
+
+#include "../grid.h"
+#include "test.h"
+
+int main() {
+  std::vector<glm::ivec2> neighbors;
+  for (glm::ivec2 p : adjacent_positions({3, -2})) neighbors.push_back(p);
+  TEST(neighbors == std::vector<glm::ivec2>({{4, -2}, {3, -1}, {2, -2},
+                                             {3, -3}}),
+       true);
+  TEST(adjacent_positions({3, -2}).size(), 4u);
+
+  // Each neighbour is one step along the matching entry of adjacent_steps().
+  std::size_t i = 0;
+  for (glm::ivec2 p : adjacent_positions({0, 0}))
+    TEST(p == adjacent_steps()[i++], true);
+  TEST(i, 4u);
+}
@@ -0,0 +1,65 @@
+#include "../hpa.h"
+#include "test.h"
+
+// Clusters of 4 cut this into a 3x2 block; the only way from the left half to
+// the right half is through the gap at the bottom.
+const char* const MAZE = R"(
+############
+#....#.....#
+#....#.....#
+#....#.....#
+#..........#
+#....#.....#
+#....#.....#
+############)";
+
+// The number of steps in a path, or -1 if it wanders off or isn't connected.
+static int path_length(const Grid& grid, const HierarchicalPath& path) {
+  for (std::size_t i = 0; i + 1 < path.tiles.size(); ++i) {
+    glm::ivec2 d = glm::abs(path.tiles[i + 1] - path.tiles[i]);
+    if (d.x + d.y != 1 || !grid.at(path.tiles[i + 1]).walkable) return -1;
+  }
+  return path.tiles.size() - 1;
+}
+
+int main() {
+  Tile floor{.walkable = true, .glyph = '.'};
+  Tile wall{.walkable = false, .opaque = true, .glyph = '#'};
+  Grid grid = grid_from_string(MAZE, {{'.', floor}, {'#', wall}});
+
+  // grid_from_string() puts the last line at y = 0, so the gap is at y = 3.
+  PathHierarchy hierarchy(4);
+  hierarchy.build(grid);
+
+  HierarchicalPath path;
+  TEST(hierarchy.plan(grid, {1, 6}, {10, 6}, path), true);
+  TEST(path.tiles.size(), 1u);  // Nothing's refined yet.
+  TEST(path.waypoints.front() == glm::ivec2(1, 6), true);
+  TEST(path.waypoints.back() == glm::ivec2(10, 6), true);
+
+  hierarchy.refine(grid, path, 2);
+  TEST(path.tiles.size() >= 2 && !path.fully_refined(), true);
+
+  hierarchy.refine(grid, path, 1000);
+  TEST(path.fully_refined(), true);
+  TEST(path.tiles.back() == glm::ivec2(10, 6), true);
+  // The shortest path is 15 steps; the hierarchy may cost a few more.
+  TEST(path_length(grid, path) >= 15 && path_length(grid, path) <= 19, true);
+
+  // Close the gap...
+  TEST_WITH(grid.set({5, 3}, wall); hierarchy.update(grid),
+            hierarchy.plan(grid, {1, 6}, {10, 6}, path), false);
+
+  // ...and open another one.
+  TEST_WITH(grid.set({5, 6}, floor); hierarchy.update(grid),
+            hierarchy.plan(grid, {1, 6}, {10, 6}, path), true);
+  hierarchy.refine(grid, path, 1000);
+  TEST(path_length(grid, path) >= 9 && path_length(grid, path) <= 13, true);
+
+  // Within a single cluster.
+  TEST(hierarchy.plan(grid, {1, 1}, {2, 2}, path), true);
+  hierarchy.refine(grid, path, 1000);
+  TEST(path_length(grid, path), 2);
+
+  TEST(hierarchy.plan(grid, {0, 0}, {2, 2}, path), false);
+}
@@ -0,0 +1,52 @@
+#include "../jps.h"
+#include "math.h"
+#include "test.h"
+
+const char* const ROOMS = R"(
+##########################################################################
+#...................................#....................................#
+#...................................#....................................#
+#........................................................................#
+##########################################################################)";
+
+int main() {
+  Tile floor{.walkable = true, .glyph = '.'};
+  Tile wall{.walkable = false, .opaque = true, .glyph = '#'};
+  Grid grid = grid_from_string(ROOMS, {{'.', floor}, {'#', wall}});
+
+  // Wider than a word, to catch bits lost between them.
+  BitGrid bits = walkable_bits(grid);
+  TEST(bits.get({0, 1}), false);
+  TEST(bits.get({1, 1}), true);
+  TEST(bits.get({36, 3}), false);
+  TEST(bits.get({72, 1}), true);
+  TEST(bits.get({73, 1}), false);
+  TEST(bits.get({-5, 1}), false);
+  TEST(bits.bits_from({70, 1}), 0b0111u);
+  TEST(bits.bits_until({2, 1}) >> 61, 0b110u);
+
+  // The top row is y = 3 and the gap is along the bottom, y = 1.
+  JumpPointSearch jps;
+  std::vector<glm::ivec2> path;
+  TEST(jps.find_path(bits, {1, 3}, {72, 3}, path), true);
+  TEST(path.size(), 76u);
+  TEST(path.front() == glm::ivec2(1, 3) && path.back() == glm::ivec2(72, 3),
+       true);
+  bool connected = true;
+  for (std::size_t i = 0; i + 1 < path.size(); ++i)
+    connected = connected && manh_dist(path[i], path[i + 1]) == 1 &&
+                bits.get(path[i + 1]);
+  TEST(connected, true);
+
+  // Going the other way round.
+  TEST(jps.find_path(bits, {72, 2}, {1, 2}, path), true);
+  TEST(path.size(), 74u);
+
+  // Only the jump points go on the open list, not every tile.
+  TEST(jps.n_expanded() < 10, true);
+
+  // Leaving a unit out of the bits blocks the way.
+  bits.set({36, 1}, false);
+  TEST(jps.find_path(bits, {1, 3}, {72, 3}, path), false);
+  TEST(path.empty(), true);
+}
@@ -0,0 +1,63 @@
+#include "../mapgen.h"
+#include "test.h"
+
+static bool same_map(MapGenParams a, MapGenParams b) {
+  std::unordered_map<char, Tile> tile_types = {
+    {MAP_WALL, Tile{.walkable = false, .glyph = MAP_WALL}},
+    {MAP_FLOOR, Tile{.walkable = true, .glyph = MAP_FLOOR}},
+  };
+  Grid grid_a = generate_grid(a, tile_types);
+  Grid grid_b = generate_grid(b, tile_types);
+  if (grid_a.data_.size() != grid_b.data_.size()) return false;
+  for (const auto& [pos, tile] : grid_a)
+    if (grid_b.at(pos).glyph != tile.glyph) return false;
+  return true;
+}
+
+static bool walled_in(const MapGenParams& params) {
+  for (const MapChunk& chunk : generate_map_chunks(params)) {
+    for (int y = 0; y < chunk.size.y; ++y) {
+      for (int x = 0; x < chunk.size.x; ++x) {
+        glm::ivec2 pos = chunk.origin + glm::ivec2(x, y);
+        bool border = pos.x == 0 || pos.y == 0 ||
+                      pos.x == params.dimensions.x - 1 ||
+                      pos.y == params.dimensions.y - 1;
+        if (border && chunk.at({x, y}) != MAP_WALL) return false;
+      }
+    }
+  }
+  return true;
+}
+
+int main() {
+  MapGenParams rooms;
+  rooms.dimensions = {100, 70};
+  rooms.chunk_size = 16;
+  rooms.seed = 42;
+
+  MapGenParams caves = rooms;
+  caves.style = MapGenParams::CAVES;
+
+  TEST_WITH(MapGenParams a = rooms; MapGenParams b = rooms;
+            a.n_threads = 1; b.n_threads = 5,
+            same_map(a, b), true);
+  TEST_WITH(MapGenParams a = caves; MapGenParams b = caves;
+            a.n_threads = 1; b.n_threads = 5,
+            same_map(a, b), true);
+
+  // Caves don't care how they're chunked, either.
+  TEST_WITH(MapGenParams a = caves; MapGenParams b = caves;
+            b.chunk_size = 7,
+            same_map(a, b), true);
+
+  TEST_WITH(MapGenParams b = rooms; b.seed = 43,
+            same_map(rooms, b), false);
+
+  TEST(walled_in(rooms), true);
+  TEST(walled_in(caves), true);
+
+  // The comma inside the braces would split TEST_WITH's arguments.
+  MapGenParams odd = rooms;
+  odd.dimensions = {37, 21};
+  TEST(walled_in(odd), true);
+}
@@ -0,0 +1,63 @@
+#include <vector>
+
+#include "../dijkstra.h"
+#include "../paths.h"
+#include "test.h"
+
+int main() {
+  PathPool pool;
+  PathHandle a = pool.acquire();
+  PathHandle b = pool.acquire();
+  TEST(pool.valid(a), true);
+  TEST(pool.valid(PathHandle()), false);
+  pool.get(a).push_back({1, 2});
+  TEST(pool.get(a).size(), 1u);
+  TEST(pool.get(b).size(), 0u);
+
+  // Released handles go stale even once their slot is reused.
+  pool.release(a);
+  TEST(pool.valid(a), false);
+  PathHandle c = pool.acquire();
+  TEST(c.index, a.index);
+  TEST(pool.valid(a), false);
+  TEST(pool.valid(c), true);
+  TEST(pool.get(c).size(), 0u);
+  pool.release(a);  // Does nothing.
+  TEST(pool.valid(c), true);
+  TEST(pool.size(), 2u);
+
+  // Paths written into the pool match the ones that are returned.
+  Tile floor{.walkable = true, .glyph = '.'};
+  Tile wall{.walkable = false, .opaque = true, .glyph = '#'};
+  Grid grid = arena_grid({40, 40}, wall, floor);
+  DijkstraGrid field;
+  field.generate(grid, {}, {20, 20});
+  path_to(field, {3, 5}, pool.get(c));
+  TEST(pool.get(c) == path_to(field, {3, 5}), true);
+
+  // Walking 500 units a turn for a few turns only ever needs 500 paths, and
+  // after the first turn, each one fits in the memory of the last.
+  PathPool units;
+  std::vector<PathHandle> handles;
+  std::vector<const glm::vec2*> memory;
+  bool reused = true;
+  for (int turn = 0; turn < 3; ++turn) {
+    for (int i = 0; i < 500; ++i) {
+      handles.push_back(units.acquire());
+      path_to(field, {1 + i % 38, 1 + (i * 7 + turn) % 38},
+              units.get(handles.back()));
+      if (turn == 0) {
+        units.get(handles.back()).reserve(80);
+        memory.push_back(units.get(handles.back()).data());
+      } else {
+        reused = reused && units.get(handles.back()).data() ==
+                           memory[handles.back().index];
+      }
+    }
+    for (PathHandle h : handles) units.release(h);
+    handles.clear();
+  }
+  TEST(reused, true);
+  TEST(units.capacity(), 500u);
+  TEST(units.size(), 0u);
+}
@@ -0,0 +1,71 @@
+#include <vector>
+
+#include "../reach.h"
+#include "math.h"
+#include "random.h"
+#include "test.h"
+
+const char* const ROOM = R"(
+#######
+#.....#
+#.#####
+#.....#
+#######)";
+
+// Grows the bits the slow way, checking every pair of tiles.
+static bool same_as_every_pair(const BitGrid& bits, const BitGrid& grown,
+                               int range) {
+  for (int y = grown.min().y - 1; y <= grown.min().y + grown.size().y; ++y) {
+    for (int x = grown.min().x - 1; x <= grown.min().x + grown.size().x; ++x) {
+      bool near = false;
+      for (int by = 0; by < bits.size().y && !near; ++by)
+        for (int bx = 0; bx < bits.size().x && !near; ++bx) {
+          glm::ivec2 b = bits.min() + glm::ivec2(bx, by);
+          near = bits.get(b) && int(diamond_dist(b, glm::ivec2(x, y))) <= range;
+        }
+      if (grown.get({x, y}) != near) return false;
+    }
+  }
+  return true;
+}
+
+int main() {
+  // Widths either side of a word, so bits have to carry between them.
+  bool same = true;
+  int round = 0;
+  for (glm::ivec2 size : {glm::ivec2(5, 4), glm::ivec2(63, 3),
+                          glm::ivec2(64, 5), glm::ivec2(130, 4)}) {
+    for (int range : {0, 1, 3}) {
+      BitGrid bits({-3, 2}, size);
+      for (int i = 0; i < 6; ++i)
+        bits.set(bits.min() + glm::ivec2(hash_coords(1, round, i) % size.x,
+                                         hash_coords(2, round, i) % size.y),
+                 true);
+      same = same && same_as_every_pair(bits, dilate(bits, range), range);
+      ++round;
+    }
+  }
+  TEST(same, true);
+
+  Tile floor{.walkable = true, .glyph = '.'};
+  Tile wall{.walkable = false, .opaque = true, .glyph = '#'};
+  Grid grid = grid_from_string(ROOM, {{'.', floor}, {'#', wall}});
+
+  // From the top left, with someone standing to the right, two steps only
+  // reach down the left side.
+  DijkstraGrid moves(PathCosts::STEPS);
+  std::vector<Occupant> units = {{{1, 3}, EntityId{1}}, {{2, 3}, EntityId{2}}};
+  moves.generate(grid, units, std::vector<glm::ivec2>{{1, 3}});
+  BitGrid stand = standable_bits(moves, 2);
+  TEST(stand.get({1, 3}), true);
+  TEST(stand.get({2, 3}), false);  // Someone's there.
+  TEST(stand.get({3, 3}), false);  // Blocked by them.
+  TEST(stand.get({1, 1}), true);
+  TEST(stand.get({1, 2}), true);
+
+  BitGrid reach = attack_reach(moves, 2, 1);
+  TEST(reach.get({2, 1}), true);
+  TEST(reach.get({2, 3}), true);
+  TEST(reach.get({3, 3}), false);
+  TEST(reach.get({3, 1}), false);
+}
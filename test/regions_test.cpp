@@ -0,0 +1,42 @@
+#include "../regions.h"
+#include "test.h"
+
+const char* const TWO_ROOMS = R"(
+#######
+#..#..#
+#..#..#
+#######)";
+
+int main() {
+  Tile floor{.walkable = true, .glyph = '.'};
+  Tile wall{.walkable = false, .opaque = true, .glyph = '#'};
+  Grid grid = grid_from_string(TWO_ROOMS, {{'.', floor}, {'#', wall}});
+
+  RegionMap regions;
+  regions.build(grid);
+  TEST(regions.connected({1, 1}, {2, 2}), true);
+  TEST(regions.connected({1, 1}, {4, 1}), false);
+  TEST(regions.connected({1, 1}, {3, 1}), false);  // Walls go nowhere.
+  TEST(regions.region({3, 1}), RegionMap::NO_REGION);
+
+  // Knock down the wall...
+  TEST_WITH(grid.set({3, 1}, floor); regions.update(grid),
+            regions.connected({1, 1}, {5, 2}), true);
+
+  // ...and put it back.
+  TEST_WITH(grid.set({3, 1}, wall); regions.update(grid),
+            regions.connected({1, 1}, {5, 2}), false);
+  TEST(regions.connected({1, 1}, {2, 2}), true);
+  TEST(regions.connected({4, 1}, {5, 2}), true);
+
+  // Splitting a room down the middle.
+  TEST_WITH(grid.set({1, 2}, wall); grid.set({2, 1}, wall);
+            regions.update(grid),
+            regions.connected({1, 1}, {2, 2}), false);
+
+  // Several changes at once, including one undone in the same batch.
+  TEST_WITH(grid.set({3, 2}, floor); grid.set({2, 1}, floor);
+            grid.set({4, 2}, wall); grid.set({4, 2}, floor);
+            regions.update(grid),
+            regions.connected({1, 1}, {5, 1}), true);
+}
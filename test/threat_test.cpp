@@ -0,0 +1,86 @@
+#include <span>
+#include <vector>
+
+#include "../threat.h"
+#include "math.h"
+#include "random.h"
+#include "test.h"
+
+// Everything on `team` that could move to a tile within range of `pos`, the
+// slow way.
+static int brute_influence(std::span<const ThreatMap::Unit> units, Team team,
+                           glm::ivec2 pos) {
+  int total = 0;
+  for (const ThreatMap::Unit& unit : units) {
+    if (unit.team != team) continue;
+    bool hits = false;
+    for (int y = -unit.range; y <= unit.range; ++y)
+      for (int x = -unit.range; x <= unit.range; ++x)
+        hits = hits || int(manh_dist(pos + glm::ivec2(x, y), unit.pos)) <=
+                       unit.move;
+    if (hits) total += unit.strength;
+  }
+  return total;
+}
+
+int main() {
+  // Attacks reach diagonally, so a unit that can move to (4, 0) can hit
+  // (5, 1), just past the diamond of move + range.
+  ThreatMap threats;
+  std::vector<ThreatMap::Unit> units = {
+    {EntityId{1}, {0, 0}, Team::CPU, 4, 1, 3},
+  };
+  threats.update({-10, -10}, {10, 10}, units);
+  TEST(threats.threat_to(Team::PLAYER, {5, 1}), 3);
+  TEST(threats.threat_to(Team::PLAYER, {3, 3}), 3);
+  TEST(threats.threat_to(Team::PLAYER, {4, 4}), 0);
+  TEST(threats.threat_to(Team::PLAYER, {6, 0}), 0);
+  TEST(threats.threat_to(Team::CPU, {5, 1}), 0);
+  TEST(threats.threat_to(Team::PLAYER, {50, 50}), 0);
+
+  // The same as working it out the slow way, including where it's cut off at
+  // the edges.
+  units = {
+    {EntityId{1}, {5, 5}, Team::PLAYER, 2, 1, 4},
+    {EntityId{2}, {6, 5}, Team::CPU, 1, 3, 3},
+    {EntityId{3}, {0, 0}, Team::PLAYER, 3, 2, 5},
+    {EntityId{4}, {11, 2}, Team::CPU, 0, 2, 1},
+    {EntityId{5}, {8, 10}, Team::CPU, 4, 0, 2},
+  };
+  threats.update({0, 0}, {12, 12}, units);
+  bool same = true;
+  for (int y = 0; y < 12; ++y)
+    for (int x = 0; x < 12; ++x)
+      for (Team team : {Team::PLAYER, Team::CPU})
+        same = same && threats.influence(team, {x, y}) ==
+                       brute_influence(units, team, {x, y});
+  TEST(same, true);
+
+  // Only the units that moved get restamped, and the result is the same as
+  // starting over.
+  units.clear();
+  for (unsigned int i = 0; i < 30; ++i)
+    units.push_back({EntityId{i + 1}, {int(i % 20), int(i / 2)},
+                     i % 3 ? Team::CPU : Team::PLAYER, int(i % 5),
+                     int(i % 3), int(i % 7) + 1});
+  ThreatMap moved;
+  moved.update({0, 0}, {20, 20}, units);
+  same = true;
+  for (int round = 0; round < 20; ++round) {
+    const unsigned int before = moved.n_stamped();
+    units[hash_coords(1, round, 0) % units.size()].pos =
+      {int(hash_coords(2, round, 0) % 20), int(hash_coords(3, round, 0) % 20)};
+    if (round % 5 == 4) units.pop_back();
+    moved.update({0, 0}, {20, 20}, units);
+    same = same && moved.n_stamped() - before <= 3;
+
+    ThreatMap fresh;
+    fresh.update({0, 0}, {20, 20}, units);
+    for (int y = 0; y < 20; ++y)
+      for (int x = 0; x < 20; ++x)
+        for (Team team : {Team::PLAYER, Team::CPU})
+          same = same && moved.influence(team, {x, y}) ==
+                         fresh.influence(team, {x, y});
+  }
+  TEST(same, true);
+}
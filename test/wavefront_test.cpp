@@ -0,0 +1,82 @@
+#include "../dijkstra.h"
+#include "../mapgen.h"
+#include "../wavefront.h"
+#include "random.h"
+#include "test.h"
+
+const char* const ROOM = R"(
+#######
+#.....#
+#.#####
+#.....#
+#######)";
+
+// Both reach the same tiles at the same distances.
+static bool same_as_dijkstra(const Grid& grid, const BitGrid& bits,
+                             std::span<const Occupant> units,
+                             glm::ivec2 source, unsigned int max_dist) {
+  DijkstraGrid dijkstra;
+  dijkstra.generate(grid, units, source, max_dist);
+  Wavefront wavefront;
+  wavefront.generate(bits, units, source, max_dist);
+  if (wavefront.size() != dijkstra.size()) return false;
+  for (const auto& [pos, node] : dijkstra)
+    if (!wavefront.contains(pos) || wavefront.dist(pos) != node.dist)
+      return false;
+  return true;
+}
+
+int main() {
+  Tile floor{.walkable = true, .glyph = '.'};
+  Tile wall{.walkable = false, .opaque = true, .glyph = '#'};
+  Grid grid = grid_from_string(ROOM, {{'.', floor}, {'#', wall}});
+  BitGrid bits = walkable_bits(grid);
+
+  // The top row is y = 3 and the bottom, y = 1.
+  Wavefront wavefront;
+  wavefront.generate(bits, {}, {5, 3});
+  TEST(wavefront.size(), 11u);
+  TEST(wavefront.contains({0, 0}), false);
+  TEST(wavefront.contains({2, 2}), false);
+  TEST(wavefront.contains({100, 100}), false);
+  TEST(wavefront.dist({5, 1}), 10u);
+
+  wavefront.generate(bits, {}, {5, 3}, 4);
+  TEST(wavefront.size(), 5u);
+  TEST(wavefront.contains({1, 2}), false);
+
+  std::vector<Occupant> units = {{{1, 2}, EntityId{7}}};
+  wavefront.generate(bits, units, {5, 3});
+  TEST(wavefront.contains({1, 2}), true);
+  TEST(wavefront.contains({1, 1}), false);
+  wavefront.generate(bits, units, {1, 2});
+  TEST(wavefront.size(), 11u);
+
+  // Caves are wide enough to cross words and have plenty of odd corners.
+  MapGenParams params;
+  params.style = MapGenParams::CAVES;
+  params.dimensions = {150, 90};
+  params.seed = 7;
+  Grid cave = generate_grid(params, {{MAP_FLOOR, floor}, {MAP_WALL, wall}});
+  BitGrid cave_bits = walkable_bits(cave);
+  std::vector<glm::ivec2> floors;
+  for (const auto& [pos, tile] : cave)
+    if (tile.walkable) floors.push_back(pos);
+  std::sort(floors.begin(), floors.end(), [](glm::ivec2 a, glm::ivec2 b) {
+    return a.y != b.y ? a.y < b.y : a.x < b.x;
+  });
+
+  std::vector<Occupant> crowd;
+  for (unsigned int i = 0; i < 30; ++i)
+    crowd.emplace_back(floors[hash_coords(1, i, 0) % floors.size()],
+                       EntityId{i + 1});
+
+  bool same = true;
+  for (int i = 0; i < 20; ++i) {
+    glm::ivec2 source = floors[hash_coords(2, i, 0) % floors.size()];
+    same = same && same_as_dijkstra(cave, cave_bits, crowd, source,
+                                    DijkstraGrid::UNBOUNDED);
+    same = same && same_as_dijkstra(cave, cave_bits, crowd, source, 1 + i);
+  }
+  TEST(same, true);
+}
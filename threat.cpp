@@ -0,0 +1,78 @@
+#include "threat.h"
+
+#include <algorithm>
+#include <unordered_set>
+
+#include "game.h"
+
+void ThreatMap::stamp(const Unit& unit, int sign) {
+  ++n_stamped_;
+  std::vector<int>& map = influence_[unit.team];
+  if (map.empty()) map.assign(std::size_t(size_.x) * size_.y, 0);
+
+  // One run of tiles per row, cut off at the edges of the box. Rows within
+  // range of the unit are as wide as the widest row of its moves plus range on
+  // either side; past that, each row is one narrower, as the diamond is.
+  const int value = sign * unit.strength;
+  const int reach = unit.move + unit.range;
+  const int first_y = std::max(unit.pos.y - reach, min_.y);
+  const int last_y = std::min(unit.pos.y + reach, min_.y + size_.y - 1);
+  for (int y = first_y; y <= last_y; ++y) {
+    const int width =
+      reach - std::max(0, std::abs(y - unit.pos.y) - unit.range);
+    const int first_x = std::max(unit.pos.x - width, min_.x);
+    const int last_x = std::min(unit.pos.x + width, min_.x + size_.x - 1);
+    if (first_x > last_x) continue;
+    int* row = &map[index({first_x, y})];
+    for (int x = first_x; x <= last_x; ++x) *row++ += value;
+  }
+}
+
+void ThreatMap::update(glm::ivec2 min, glm::ivec2 max,
+                       std::span<const Unit> units) {
+  if (min != min_ || max - min != size_) {
+    min_ = min;
+    size_ = glm::max(max - min, glm::ivec2(0, 0));
+    influence_.clear();
+    units_.clear();
+  }
+
+  std::unordered_set<unsigned int> present;
+  for (const Unit& unit : units) {
+    present.insert(unit.id.id);
+    auto [it, inserted] = units_.try_emplace(unit.id.id, unit);
+    if (!inserted && it->second == unit) continue;
+    if (!inserted) stamp(it->second, -1);
+    it->second = unit;
+    stamp(unit, 1);
+  }
+
+  std::erase_if(units_, [&](const auto& id_unit) {
+    if (present.contains(id_unit.first)) return false;
+    stamp(id_unit.second, -1);
+    return true;
+  });
+}
+
+void ThreatMap::update(const Game& game) {
+  std::vector<Unit> units;
+  for (const auto& [id, gpos, actor, agent] :
+       game.ecs().read_all<GridPos, Actor, Agent>())
+    units.push_back({id, gpos.pos, agent.team, int(actor.stats.move),
+                     int(actor.stats.range), int(actor.stats.strength)});
+  update(game.grid().bounds_min(), game.grid().bounds_max(), units);
+}
+
+int ThreatMap::influence(Team team, glm::ivec2 pos) const {
+  auto it = influence_.find(team);
+  if (!in_box(pos) || it == influence_.end()) return 0;
+  return it->second[index(pos)];
+}
+
+int ThreatMap::threat_to(Team team, glm::ivec2 pos) const {
+  if (!in_box(pos)) return 0;
+  int total = 0;
+  for (const auto& [other, map] : influence_)
+    if (other != team) total += map[index(pos)];
+  return total;
+}
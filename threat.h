@@ -0,0 +1,71 @@
+#pragma once
+
+// Influence maps: for each team, how much harm it could do to each tile next
+// turn. Every unit stamps its strength over the tiles it could move to and
+// then hit: the diamond of its moves, grown by its range in every direction,
+// diagonals included, since attacks measure range with diamond_dist(). Asking
+// how dangerous a tile is then takes one lookup instead of working out what
+// every enemy could reach.
+//
+// Walls and other units aren't taken into account, so this errs on the side
+// of caution: a tile behind a wall may look as dangerous as one in the open.
+
+#include <map>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/vec2.hpp>
+
+#include "components.h"
+
+class ThreatMap {
+public:
+  // What a unit brings to the map.
+  struct Unit {
+    EntityId id;
+    glm::ivec2 pos;
+    Team team;
+    int move;
+    int range;
+    int strength;  // Added to every tile in reach.
+
+    bool operator==(const Unit& other) const = default;
+  };
+
+private:
+  // Every map covers the box [min_, min_ + size_), the grid's bounding box.
+  glm::ivec2 min_ = {0, 0};
+  glm::ivec2 size_ = {0, 0};
+  std::map<Team, std::vector<int>> influence_;
+
+  // The units as they were last stamped, keyed by EntityId::id.
+  std::unordered_map<unsigned int, Unit> units_;
+  unsigned int n_stamped_ = 0;
+
+  bool in_box(glm::ivec2 p) const {
+    return p.x >= min_.x && p.y >= min_.y &&
+           p.x < min_.x + size_.x && p.y < min_.y + size_.y;
+  }
+  std::size_t index(glm::ivec2 p) const {
+    return std::size_t(p.y - min_.y) * size_.x + (p.x - min_.x);
+  }
+
+  // Adds or, with a sign of -1, takes away a unit's strength.
+  void stamp(const Unit& unit, int sign);
+
+public:
+  // Brings the maps up to date, only restamping units that moved, changed or
+  // came and went since last time. Everything is restamped if the box grows.
+  void update(glm::ivec2 min, glm::ivec2 max, std::span<const Unit> units);
+  void update(const Game& game);
+
+  // The strength of every unit on `team` that could reach `pos`.
+  int influence(Team team, glm::ivec2 pos) const;
+
+  // The strength of every unit not on `team` that could reach `pos`.
+  int threat_to(Team team, glm::ivec2 pos) const;
+
+  // How many times a unit has been stamped onto or off of the maps.
+  unsigned int n_stamped() const { return n_stamped_; }
+};
@@ -0,0 +1,169 @@
+#include "wavefront.h"
+
+#include <algorithm>
+#include <bit>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#if defined(__AVX2__)
+constexpr int LANES = 4;
+#elif defined(__SSE2__)
+constexpr int LANES = 2;
+#else
+constexpr int LANES = 1;
+#endif
+
+void Wavefront::generate(const BitGrid& walkable,
+                         std::span<const Occupant> occupants,
+                         glm::ivec2 source, unsigned int max_dist) {
+  min_ = walkable.min();
+  glm::ivec2 max = walkable.min() + walkable.size();
+  if (max_dist < UNBOUNDED) {
+    const int reach = std::min<unsigned int>(max_dist, 1 << 20);
+    min_ = glm::max(min_, source - reach);
+    max = glm::min(max, source + reach + 1);
+  }
+  size_ = glm::max(max - min_, glm::ivec2(0, 0));
+
+  row_words_ = (size_.x + 64 * LANES - 1) / (64 * LANES) * LANES;
+  stride_ = row_words_ + 2;
+  const std::size_t n_words = std::size_t(stride_) * (size_.y + 2);
+  walkable_.assign(n_words, 0);
+  seen_.assign(n_words, 0);
+  frontier_.assign(n_words, 0);
+  next_.assign(n_words, 0);
+  fresh_.assign(n_words, 0);
+  dist_.resize(std::size_t(size_.x) * size_.y);
+  n_reached_ = 0;
+  n_steps_ = 0;
+
+  // Copy over the part of the grid we need, leaving anything past the right
+  // edge unset.
+  const int full_words = size_.x / 64;
+  for (int y = 0; y < size_.y; ++y) {
+    std::uint64_t* out = &walkable_[row(y)];
+    for (int i = 0; i * 64 < size_.x; ++i)
+      out[i] = walkable.bits_from(min_ + glm::ivec2(i * 64, y));
+    if (size_.x % 64)
+      out[full_words] &= (std::uint64_t(1) << (size_.x % 64)) - 1;
+  }
+
+  expands_ = walkable_;
+  for (const auto& [pos, id] : occupants) {
+    if (!in_box(pos) || pos == source) continue;
+    const int x = pos.x - min_.x;
+    expands_[row(pos.y - min_.y) + x / 64] &= ~(std::uint64_t(1) << (x % 64));
+  }
+
+  if (!in_box(source) || !test(walkable_, source)) return;
+  set(seen_, source);
+  set(frontier_, source);
+  dist_[(source.y - min_.y) * size_.x + (source.x - min_.x)] = 0;
+  n_reached_ = 1;
+
+  // Rows [lo, hi] are the only ones the frontier might have bits in.
+  int lo = source.y - min_.y, hi = lo;
+  for (unsigned int dist = 1; dist <= max_dist && lo <= hi; ++dist) {
+    ++n_steps_;
+    const int first = std::max(lo - 1, 0);
+    const int last = std::min(hi + 1, size_.y - 1);
+    int next_lo = size_.y, next_hi = -1;
+    for (int y = first; y <= last; ++y) {
+      spread_row(y);
+
+      // Write down how far the new tiles are, one at a time, and check if
+      // any of them can be spread from next time.
+      const std::size_t r = row(y);
+      std::uint64_t any_next = 0;
+      unsigned int* dists = &dist_[std::size_t(y) * size_.x];
+      for (int i = 0; i < row_words_; ++i) {
+        any_next |= next_[r + i];
+        for (std::uint64_t bits = fresh_[r + i]; bits; bits &= bits - 1) {
+          dists[i * 64 + std::countr_zero(bits)] = dist;
+          ++n_reached_;
+        }
+      }
+      if (any_next) {
+        next_lo = std::min(next_lo, y);
+        next_hi = y;
+      }
+    }
+
+    // Clear out the old frontier so it can be written over as the next one.
+    std::fill(frontier_.begin() + row(lo), frontier_.begin() + row(hi + 1),
+              0);
+    std::swap(frontier_, next_);
+    lo = next_lo;
+    hi = next_hi;
+  }
+}
+
+void Wavefront::spread_row(int y) {
+  const std::size_t r = row(y);
+  const std::uint64_t* f = &frontier_[r];
+  const std::uint64_t* up = f + stride_;
+  const std::uint64_t* down = f - stride_;
+  const std::uint64_t* walkable = &walkable_[r];
+  const std::uint64_t* expands = &expands_[r];
+  std::uint64_t* seen = &seen_[r];
+  std::uint64_t* next = &next_[r];
+  std::uint64_t* fresh = &fresh_[r];
+
+  // A tile is spread to from the left by shifting up a bit, and the top bit
+  // of the word before carries over. Likewise to the right.
+#if defined(__AVX2__)
+  for (int i = 0; i < row_words_; i += 4) {
+    auto load = [](const std::uint64_t* p) {
+      return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    };
+    const __m256i w = load(f + i);
+    __m256i spread = _mm256_or_si256(load(up + i), load(down + i));
+    spread = _mm256_or_si256(spread, _mm256_slli_epi64(w, 1));
+    spread = _mm256_or_si256(spread, _mm256_srli_epi64(load(f + i - 1), 63));
+    spread = _mm256_or_si256(spread, _mm256_srli_epi64(w, 1));
+    spread = _mm256_or_si256(spread, _mm256_slli_epi64(load(f + i + 1), 63));
+    const __m256i s = load(seen + i);
+    const __m256i n =
+      _mm256_andnot_si256(s, _mm256_and_si256(spread, load(walkable + i)));
+    auto store = [](std::uint64_t* p, __m256i v) {
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v);
+    };
+    store(seen + i, _mm256_or_si256(s, n));
+    store(fresh + i, n);
+    store(next + i, _mm256_and_si256(n, load(expands + i)));
+  }
+#elif defined(__SSE2__)
+  for (int i = 0; i < row_words_; i += 2) {
+    auto load = [](const std::uint64_t* p) {
+      return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    };
+    const __m128i w = load(f + i);
+    __m128i spread = _mm_or_si128(load(up + i), load(down + i));
+    spread = _mm_or_si128(spread, _mm_slli_epi64(w, 1));
+    spread = _mm_or_si128(spread, _mm_srli_epi64(load(f + i - 1), 63));
+    spread = _mm_or_si128(spread, _mm_srli_epi64(w, 1));
+    spread = _mm_or_si128(spread, _mm_slli_epi64(load(f + i + 1), 63));
+    const __m128i s = load(seen + i);
+    const __m128i n =
+      _mm_andnot_si128(s, _mm_and_si128(spread, load(walkable + i)));
+    auto store = [](std::uint64_t* p, __m128i v) {
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v);
+    };
+    store(seen + i, _mm_or_si128(s, n));
+    store(fresh + i, n);
+    store(next + i, _mm_and_si128(n, load(expands + i)));
+  }
+#else
+  for (int i = 0; i < row_words_; ++i) {
+    const std::uint64_t spread = up[i] | down[i] |
+                                 f[i] << 1 | f[i - 1] >> 63 |
+                                 f[i] >> 1 | f[i + 1] << 63;
+    const std::uint64_t n = spread & walkable[i] & ~seen[i];
+    seen[i] |= n;
+    fresh[i] = n;
+    next[i] = n & expands[i];
+  }
+#endif
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+// Breadth-first search a whole row of tiles at a time. Each step spreads the
+// frontier one tile in every direction with shifts and ORs over 64-bit words,
+// then masks it by what's walkable and not seen yet, so the work per step is
+// proportional to the rows the frontier spans rather than the tiles in it.
+// With SSE2 or AVX2, several words are spread at once.
+//
+// It only counts steps, and only finds distances, not paths, which makes it
+// a good fit for showing how far a unit can move or asking what it can reach.
+
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+#include <glm/vec2.hpp>
+
+#include "bitboard.h"
+#include "components.h"
+
+class Wavefront {
+  // The box [min_, min_ + size_), as in DijkstraGrid. Every array below holds
+  // one padded row per row of the box, with a row of zeros above and below
+  // and a word of zeros on either side, so that spreading never has to check
+  // for edges.
+  glm::ivec2 min_ = {0, 0};
+  glm::ivec2 size_ = {0, 0};
+  int row_words_ = 0;  // Words of tiles in a row, rounded up for SIMD.
+  int stride_ = 0;     // Words from one row to the next, with padding.
+
+  std::vector<std::uint64_t> walkable_;
+  std::vector<std::uint64_t> expands_;   // Walkable and not occupied.
+  std::vector<std::uint64_t> seen_;
+  std::vector<std::uint64_t> frontier_;  // Tiles to spread from this step.
+  std::vector<std::uint64_t> next_;      // And next step.
+  std::vector<std::uint64_t> fresh_;     // Reached this step.
+
+  // Indexed by (y - min_.y) * size_.x + (x - min_.x). Only means something
+  // for tiles that have been seen.
+  std::vector<unsigned int> dist_;
+
+  std::size_t n_reached_ = 0;
+  unsigned int n_steps_ = 0;
+
+  bool in_box(glm::ivec2 p) const {
+    return p.x >= min_.x && p.y >= min_.y &&
+           p.x < min_.x + size_.x && p.y < min_.y + size_.y;
+  }
+  // The first word of a row, counting up from min_.y.
+  std::size_t row(int y) const { return std::size_t(y + 1) * stride_ + 1; }
+  bool test(const std::vector<std::uint64_t>& bits, glm::ivec2 p) const {
+    const int x = p.x - min_.x;
+    return bits[row(p.y - min_.y) + x / 64] >> (x % 64) & 1;
+  }
+  void set(std::vector<std::uint64_t>& bits, glm::ivec2 p) {
+    const int x = p.x - min_.x;
+    bits[row(p.y - min_.y) + x / 64] |= std::uint64_t(1) << (x % 64);
+  }
+
+  void spread_row(int y);
+
+public:
+  static constexpr unsigned int UNBOUNDED =
+    std::numeric_limits<unsigned int>::max();
+
+  // Reaches the same tiles at the same distances as DijkstraGrid::generate()
+  // when counting steps: units block the way, but the tiles they stand on are
+  // reached, and the source can always move.
+  void generate(const BitGrid& walkable, std::span<const Occupant> occupants,
+                glm::ivec2 source, unsigned int max_dist = UNBOUNDED);
+
+  bool contains(glm::ivec2 p) const { return in_box(p) && test(seen_, p); }
+
+  unsigned int dist(glm::ivec2 p) const {
+    return dist_[(p.y - min_.y) * size_.x + (p.x - min_.x)];
+  }
+
+  // The number of tiles reached.
+  std::size_t size() const { return n_reached_; }
+
+  // How many times the frontier was spread.
+  unsigned int n_steps() const { return n_steps_; }
+};